@@ -0,0 +1,97 @@
+/*
+ * AdcScheduler.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "AdcScheduler.h"
+#include <Arduino.h>
+
+/**
+ * Adds an analog input to the scheduler, its first value is read at once
+ * with analogRead(), so the inputs must be added before the first poll().
+ * @param channel Analog channel of the input (A0 - A3 on the ATtiny85)
+ * @return Index of the input, 0xFF if there is no room for it
+ */
+uint8_t AdcScheduler::addChannel(uint8_t channel)
+{
+  if(this->_count >= ADC_MAX_CHANNELS)
+  {
+    return 0xFF;
+  }
+  uint8_t index = this->_count++;
+  this->_channels[index] = channel;
+  this->_values[index] = analogRead(channel);
+  return index;
+}
+
+/**
+ * Starts the conversion of the current input.
+ */
+void AdcScheduler::start(void)
+{
+#if defined(__AVR__)
+  uint8_t channel = this->_channels[this->_current];
+#if defined(__AVR_ATtiny85__)
+  ADMUX = channel & 0x03;
+#else
+  ADMUX = _BV(REFS0) | (channel & 0x07);
+#endif
+  ADCSRA |= _BV(ADSC);
+  this->_converting = true;
+#else
+  this->_values[this->_current] = analogRead(this->_channels[this->_current]);
+  if(++this->_current >= this->_count)
+  {
+    this->_current = 0;
+  }
+#endif
+}
+
+/**
+ * Takes the result of the running conversion, if it is complete, and starts
+ * the next one. It must be called periodically, each input is read every
+ * count calls.
+ */
+void AdcScheduler::poll(void)
+{
+  if(this->_count == 0)
+  {
+    return;
+  }
+#if defined(__AVR__)
+  if(this->_converting)
+  {
+    if(ADCSRA & _BV(ADSC))
+    {
+      return;
+    }
+    this->_values[this->_current] = ADC;
+    this->_converting = false;
+    if(++this->_current >= this->_count)
+    {
+      this->_current = 0;
+    }
+  }
+#endif
+  this->start();
+}
+
+/**
+ * Drops the running conversion, so the ADC can be used by the AudioAnalyzer.
+ * The scheduler starts again from the next poll().
+ */
+void AdcScheduler::pause(void)
+{
+  this->_converting = false;
+}
+
+/**
+ * It allows to obtain the last value read from an input (0 - 1023).
+ * @param index Index of the input given by addChannel()
+ */
+uint16_t AdcScheduler::getValue(uint8_t index)
+{
+  return index < this->_count ? this->_values[index] : 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * AdcScheduler.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef ADC_SCHEDULER_H_
+#define ADC_SCHEDULER_H_
+
+#define ADC_MAX_CHANNELS 2
+
+/**
+ * AdcScheduler reads several analog inputs in turn without waiting for the
+ * conversions: each call of poll() takes the result of the conversion started
+ * by the previous one and starts the conversion of the next input, so the
+ * loop never blocks on the ADC (~100 us per conversion). The last value of
+ * each input can be read at any time.
+ * The ADC is shared with the AudioAnalyzer, the scheduler must be paused
+ * while the analyzer is running.
+ */
+class AdcScheduler
+{
+  private:
+    uint8_t _channels[ADC_MAX_CHANNELS];
+    uint16_t _values[ADC_MAX_CHANNELS];
+    uint8_t _count = 0;
+    uint8_t _current = 0;
+    bool _converting = false;
+
+    void start(void);
+
+  public:
+    uint8_t addChannel(uint8_t);
+    void poll(void);
+    void pause(void);
+    uint16_t getValue(uint8_t);
+};
+
+#endif /* ADC_SCHEDULER_H_ */
@@ -0,0 +1,181 @@
+/*
+ * AudioAnalyzer.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "AudioAnalyzer.h"
+#include <Arduino.h>
+
+// Analyzer that receives the samples of the ADC interruption
+static AudioAnalyzer *audio_analyzer_instance = nullptr;
+
+/**
+ * Constructor of the class.
+ * @param channel Analog channel of the audio input (A0 - A3)
+ */
+AudioAnalyzer::AudioAnalyzer(uint8_t channel)
+{
+  this->_channel = channel;
+}
+
+/**
+ * Allows to adjust the sensitivity to the input level. The envelopes are
+ * divided by 2^gain to obtain the 8 bits levels, so a lower value is more
+ * sensitive. By default is 4.
+ * @param gain Shift applied to the envelopes
+ */
+void AudioAnalyzer::setGain(uint8_t gain)
+{
+  this->_gain = gain;
+}
+
+/**
+ * Configures the ADC in free running mode with the conversion complete
+ * interruption. While the analyzer is running analogRead() must not be used.
+ */
+void AudioAnalyzer::begin(void)
+{
+  if(this->_running)
+  {
+    return;
+  }
+  audio_analyzer_instance = this;
+  this->_running = true;
+#if defined(__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+#if defined(__AVR_ATtiny85__)
+  ADMUX = this->_channel & 0x03;
+#else
+  ADMUX = _BV(REFS0) | (this->_channel & 0x07);
+#endif
+  ADCSRB = 0;
+  ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) |
+    _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  SREG = sreg;
+#endif
+}
+
+/**
+ * Stops the sampling and returns the ADC to the configuration expected by
+ * analogRead().
+ */
+void AudioAnalyzer::end(void)
+{
+  if(!this->_running)
+  {
+    return;
+  }
+#if defined(__AVR__)
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+#endif
+  this->_running = false;
+}
+
+/**
+ * It allows to know if the analyzer is sampling the audio input.
+ */
+bool AudioAnalyzer::isRunning(void)
+{
+  return this->_running;
+}
+
+/**
+ * Envelope follower with fast attack (1/4) and slow release (~50 ms).
+ */
+uint16_t AudioAnalyzer::follow(uint16_t envelope, int16_t value)
+{
+  uint16_t level = value < 0 ? -value : value;
+  if(level > envelope)
+  {
+    return envelope + ((level - envelope) >> 2);
+  }
+  return envelope - (envelope >> 9) - (envelope > 0 ? 1 : 0);
+}
+
+/**
+ * Processes a sample of the audio input. It is called from the ADC
+ * interruption, but it can be fed with any source of samples.
+ * @param sample Sample centered on zero (-512 to 511)
+ */
+void AudioAnalyzer::process(int16_t sample)
+{
+  int16_t x = sample * 16;
+  this->_dc += x - (this->_dc >> 8);
+  int16_t dc = this->_dc >> 8;
+  // One pole low pass filters at ~200 Hz (1/8) and ~1.1 kHz (1/2)
+  this->_low_bass += (x - this->_low_bass) >> 3;
+  this->_low_mid += (x - this->_low_mid) >> 1;
+
+  this->_envelope[0] = follow(this->_envelope[0], this->_low_bass - dc);
+  this->_envelope[1] = follow(this->_envelope[1], this->_low_mid - this->_low_bass);
+  this->_envelope[2] = follow(this->_envelope[2], x - this->_low_mid);
+
+  if(++this->_beat_decimation < AUDIO_BEAT_DECIMATION)
+  {
+    return;
+  }
+  this->_beat_decimation = 0;
+  uint16_t bass = this->_envelope[0];
+  uint16_t average = this->_beat_average;
+  this->_beat_average = average + ((int16_t)(bass - average) >> 5);
+  if(this->_beat_holdoff > 0)
+  {
+    this->_beat_holdoff--;
+  }
+  else if(bass > AUDIO_BEAT_FLOOR && bass > average + (average >> 1))
+  {
+    this->_beat = true;
+    this->_beat_holdoff = AUDIO_BEAT_HOLDOFF;
+  }
+}
+
+/**
+ * It allows to obtain the level of each band as a color: bass in red, mid in
+ * green and high in blue.
+ */
+RGBColor AudioAnalyzer::getLevels(void)
+{
+  uint16_t envelope[3];
+  noInterrupts();
+  envelope[0] = this->_envelope[0];
+  envelope[1] = this->_envelope[1];
+  envelope[2] = this->_envelope[2];
+  interrupts();
+  for(uint8_t i = 0; i < 3; i++)
+  {
+    envelope[i] >>= this->_gain;
+    if(envelope[i] > 255)
+    {
+      envelope[i] = 255;
+    }
+  }
+  RGBColor levels = {
+    static_cast<uint8_t>(envelope[0]),
+    static_cast<uint8_t>(envelope[1]),
+    static_cast<uint8_t>(envelope[2])
+  };
+  return levels;
+}
+
+/**
+ * It allows to know if a beat was detected since the last call.
+ */
+bool AudioAnalyzer::beatDetected(void)
+{
+  noInterrupts();
+  bool beat = this->_beat;
+  this->_beat = false;
+  interrupts();
+  return beat;
+}
+
+#if defined(__AVR__)
+ISR(ADC_vect)
+{
+  int16_t sample = ADC;
+  audio_analyzer_instance->process(sample - 512);
+}
+#endif
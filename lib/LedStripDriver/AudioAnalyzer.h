@@ -0,0 +1,59 @@
+/*
+ * AudioAnalyzer.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "RGBColors.h"
+
+#ifndef AUDIO_ANALYZER_H_
+#define AUDIO_ANALYZER_H_
+
+// Number of samples between two evaluations of the beat detector (~6.5 ms)
+#define AUDIO_BEAT_DECIMATION 64
+// Evaluations of the beat detector ignored after a beat (~200 ms)
+#define AUDIO_BEAT_HOLDOFF 30
+// Minimum bass envelope considered as a beat
+#define AUDIO_BEAT_FLOOR 256
+
+/**
+ * AudioAnalyzer samples an audio signal from an analog input at ~9.9 kHz
+ * (free running ADC with interrupt) and splits it into three bands (bass, mid
+ * and high) with an envelope follower for each one. It also detects beats on
+ * the bass band.
+ * The filters only use additions and shifts, the ATtiny85 does not have a
+ * hardware multiplier.
+ */
+class AudioAnalyzer
+{
+  private:
+    uint8_t _channel;
+    uint8_t _gain = 4;
+    bool _running = false;
+
+    int32_t _dc = 0;
+    int16_t _low_bass = 0;
+    int16_t _low_mid = 0;
+    uint16_t _envelope[3] = { 0, 0, 0 };
+    uint16_t _beat_average = 0;
+    uint8_t _beat_decimation = 0;
+    uint8_t _beat_holdoff = 0;
+    volatile bool _beat = false;
+
+    static uint16_t follow(uint16_t, int16_t);
+
+  public:
+    AudioAnalyzer(uint8_t channel);
+    void setGain(uint8_t);
+    void begin(void);
+    void end(void);
+    bool isRunning(void);
+    void process(int16_t);
+    RGBColor getLevels(void);
+    bool beatDetected(void);
+};
+
+#endif /* AUDIO_ANALYZER_H_ */
@@ -0,0 +1,144 @@
+/*
+ * AutoBrightness.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "AutoBrightness.h"
+
+/**
+ * Constructor of the class.
+ * @param target Light level to hold, in ADC counts of the sensor (0 - 1023)
+ */
+AutoBrightness::AutoBrightness(uint16_t target)
+{
+  this->_target = target;
+}
+
+void AutoBrightness::setTarget(uint16_t target)
+{
+  this->_target = target;
+}
+
+/**
+ * Allows to cap the output scale with another limit, for example the scale of
+ * the power budget, the loop does not integrate over it.
+ * @param limit Highest output scale (0 - 255)
+ */
+void AutoBrightness::setLimit(uint8_t limit)
+{
+  this->_limit = limit;
+}
+
+/**
+ * Sets the output scale at once, for example to resume it after a reset.
+ */
+void AutoBrightness::setScale(uint8_t scale)
+{
+  this->_level = (uint16_t)(scale < AUTO_BRIGHTNESS_MIN ? AUTO_BRIGHTNESS_MIN : scale) << 8;
+}
+
+/**
+ * It allows to obtain the filtered light level (0 - 1023).
+ */
+uint16_t AutoBrightness::getLight(void)
+{
+  return this->_stage2 >> 6;
+}
+
+/**
+ * It allows to obtain the scale for the output of the LEDs (0 - 255), within
+ * the limit.
+ */
+uint8_t AutoBrightness::getScale(void)
+{
+  uint8_t scale = this->_level >> 8;
+  return scale < this->_limit ? scale : this->_limit;
+}
+
+/**
+ * Filters a reading of the sensor and advances the loop by the elapsed time.
+ * @param light Reading of the sensor (0 - 1023)
+ * @param elapsed Milliseconds since the previous update
+ */
+void AutoBrightness::update(uint16_t light, uint16_t elapsed)
+{
+  uint8_t steps = 0;
+  elapsed += this->_elapsed;
+  while(elapsed >= AUTO_BRIGHTNESS_STEP && steps < AUTO_BRIGHTNESS_MAX_STEPS)
+  {
+    this->step(light);
+    elapsed -= AUTO_BRIGHTNESS_STEP;
+    steps++;
+  }
+  this->_elapsed = elapsed < AUTO_BRIGHTNESS_STEP ? elapsed : 0;
+}
+
+/**
+ * A step of the filter and of the loop, every AUTO_BRIGHTNESS_STEP.
+ */
+void AutoBrightness::step(uint16_t light)
+{
+  // The level follows the limit down, so it does not have to unwind from
+  // above it before the LEDs dim
+  uint16_t ceiling = (uint16_t)(this->_limit > AUTO_BRIGHTNESS_MIN ? this->_limit : AUTO_BRIGHTNESS_MIN) << 8;
+  if(this->_level > ceiling)
+  {
+    this->_level = ceiling;
+  }
+
+  // The stages keep the level in 10.6 fixed point
+  uint16_t sample = light << 6;
+  if(!this->_primed)
+  {
+    this->_primed = true;
+    this->_stage1 = sample;
+    this->_stage2 = sample;
+  }
+  this->_stage1 += ((int32_t)sample - this->_stage1) >> AUTO_BRIGHTNESS_FILTER;
+  this->_stage2 += ((int32_t)this->_stage1 - this->_stage2) >> AUTO_BRIGHTNESS_FILTER;
+
+  int16_t error = (int16_t)this->_target - (int16_t)this->getLight();
+  uint16_t distance = error < 0 ? -error : error;
+  int16_t last_error = this->_last_error;
+  this->_last_error = error;
+  if(this->_holding)
+  {
+    if(distance <= AUTO_BRIGHTNESS_BAND_OUT)
+    {
+      return;
+    }
+    this->_holding = false;
+  }
+  else if(distance <= AUTO_BRIGHTNESS_BAND_IN)
+  {
+    this->_holding = true;
+    return;
+  }
+
+  int32_t delta = ((int32_t)AUTO_BRIGHTNESS_KP * (error - last_error) +
+    (int32_t)AUTO_BRIGHTNESS_KI * error) >> 4;
+  if(delta > AUTO_BRIGHTNESS_MAX_DELTA)
+  {
+    delta = AUTO_BRIGHTNESS_MAX_DELTA;
+  }
+  else if(delta < -AUTO_BRIGHTNESS_MAX_DELTA)
+  {
+    delta = -AUTO_BRIGHTNESS_MAX_DELTA;
+  }
+  if(delta > 0 && (this->_level >> 8) >= this->_limit)
+  {
+    return;
+  }
+  int32_t level = (int32_t)this->_level + delta;
+  if(level > 0xFF00)
+  {
+    level = 0xFF00;
+  }
+  else if(level < ((int32_t)AUTO_BRIGHTNESS_MIN << 8))
+  {
+    level = (int32_t)AUTO_BRIGHTNESS_MIN << 8;
+  }
+  this->_level = level;
+}
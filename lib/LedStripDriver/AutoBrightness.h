@@ -0,0 +1,74 @@
+/*
+ * AutoBrightness.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef AUTO_BRIGHTNESS_H_
+#define AUTO_BRIGHTNESS_H_
+
+// Shift of each of the two low pass stages of the light readings
+#define AUTO_BRIGHTNESS_FILTER 5
+// Gains of the PI loop (x16), the error is in ADC counts and the output scale
+// in 8.8 fixed point
+#define AUTO_BRIGHTNESS_KP 64
+#define AUTO_BRIGHTNESS_KI 8
+// Hysteresis of the loop: it stops within the inner band of the target and
+// starts again out of the outer band (ADC counts)
+#define AUTO_BRIGHTNESS_BAND_IN 8
+#define AUTO_BRIGHTNESS_BAND_OUT 24
+// Lowest output scale, the LEDs never go dark
+#define AUTO_BRIGHTNESS_MIN 32
+// Largest change of the output scale in a step (8.8 fixed point), a step
+// of the light does not jump the LEDs
+#define AUTO_BRIGHTNESS_MAX_DELTA 256
+// Milliseconds between two steps of the filter and the loop, the gains are
+// tuned for it
+#define AUTO_BRIGHTNESS_STEP 20
+// Maximum number of steps run by a single update
+#define AUTO_BRIGHTNESS_MAX_STEPS 4
+
+/**
+ * AutoBrightness scales the output of the LEDs so the light measured by a
+ * light sensor (an LDR that sees the room, lit by the strip and by the
+ * ambient) stays at a target level: the LEDs dim when there is daylight and
+ * go up when it is dark.
+ * The readings pass through two first order low pass stages (~0.6 s each)
+ * and a PI loop in velocity form computes the scale. They run every
+ * AUTO_BRIGHTNESS_STEP milliseconds whatever the frame of the board, so the
+ * response is the same at 10 and 20 ms. The gains are low and the change of
+ * a step is limited, so it takes several seconds to settle and the loop
+ * itself does not flicker, and it holds the scale while the light is within
+ * the hysteresis band of the target. The integration stops while the scale is
+ * capped by another limit (the power budget), so it does not wind up.
+ */
+class AutoBrightness
+{
+  private:
+    uint16_t _target;
+    uint16_t _stage1 = 0;
+    uint16_t _stage2 = 0;
+    bool _primed = false;
+    int16_t _last_error = 0;
+    bool _holding = false;
+    uint16_t _level = 0xFF00;
+    uint8_t _limit = 255;
+    uint8_t _elapsed = 0;
+
+    void step(uint16_t);
+
+  public:
+    AutoBrightness(uint16_t target);
+    void setTarget(uint16_t);
+    void setLimit(uint8_t);
+    void setScale(uint8_t);
+    uint16_t getLight(void);
+    uint8_t getScale(void);
+    void update(uint16_t, uint16_t);
+};
+
+#endif /* AUTO_BRIGHTNESS_H_ */
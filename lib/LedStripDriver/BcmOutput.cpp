@@ -0,0 +1,206 @@
+/*
+ * BcmOutput.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "BcmOutput.h"
+#include <Arduino.h>
+#include "BoardProfile.h"
+
+// Only the engine selected by the profile (LED_OUTPUT_BACKEND) configures
+// Timer1 and defines TIMER1_COMPA_vect, SoftPwm uses the same vector
+#if defined(__AVR__) && LED_OUTPUT_BACKEND == LED_OUTPUT_BCM
+#define BCM_OUTPUT_TIMER1
+#endif
+
+// Engine that receives the Timer1 interruptions
+static BcmOutput *bcm_output_instance = nullptr;
+
+/**
+ * Constructor of the class.
+ * @param port Output register of the port of the channels (&PORTB)
+ * @param ddr Direction register of the same port (&DDRB)
+ */
+BcmOutput::BcmOutput(volatile uint8_t *port, volatile uint8_t *ddr)
+{
+  this->_port = port;
+  this->_ddr = ddr;
+  for(uint8_t channel = 0; channel < BCM_CHANNELS; channel++)
+  {
+    this->_duty[channel] = 0;
+  }
+  for(uint8_t plane = 0; plane < BCM_PLANES; plane++)
+  {
+    this->_planes[0][plane] = 0;
+    this->_planes[1][plane] = 0;
+  }
+}
+
+/**
+ * Configures Timer1 in CTC mode and starts the generation of the channels.
+ */
+void BcmOutput::begin(void)
+{
+  bcm_output_instance = this;
+  this->_plane = 0;
+#if defined(BCM_OUTPUT_TIMER1)
+  uint8_t sreg = SREG;
+  cli();
+#if defined(__AVR_ATtiny85__)
+  GTCCR &= ~(_BV(PWM1B) | _BV(COM1B1) | _BV(COM1B0));
+  OCR1C = 0;
+  OCR1A = 0;
+  TCNT1 = 0;
+  TCCR1 = _BV(CTC1) | _BV(CS13);
+  TIFR = _BV(OCF1A);
+  TIMSK |= _BV(OCIE1A);
+#else
+  TCCR1A = 0;
+  OCR1A = 0;
+  TCNT1 = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS12);
+  TIFR1 = _BV(OCF1A);
+  TIMSK1 = _BV(OCIE1A);
+#endif
+  SREG = sreg;
+#endif
+}
+
+/**
+ * Stops Timer1 and leaves all the channels low.
+ */
+void BcmOutput::end(void)
+{
+#if defined(BCM_OUTPUT_TIMER1)
+  uint8_t sreg = SREG;
+  cli();
+#if defined(__AVR_ATtiny85__)
+  TIMSK &= ~_BV(OCIE1A);
+  TCCR1 = 0;
+#else
+  TIMSK1 = 0;
+  TCCR1B = 0;
+#endif
+  *this->_port &= ~this->_channels;
+  SREG = sreg;
+#endif
+}
+
+/**
+ * Set the bit of the channel as an output, starting low.
+ * @param channel Bit of the port (0 - 7)
+ */
+void BcmOutput::setup(uint8_t channel)
+{
+  if(channel >= BCM_CHANNELS)
+  {
+    return;
+  }
+  uint8_t bit = 1 << channel;
+  noInterrupts();
+  *this->_port &= ~bit;
+  *this->_ddr |= bit;
+  interrupts();
+  this->_channels |= bit;
+  this->build();
+}
+
+/**
+ * Changes the duty of a channel, it is applied by the next commit().
+ * @param channel Bit of the port (0 - 7)
+ * @param duty Duty of the channel (0 - 255)
+ */
+void BcmOutput::write(uint8_t channel, uint8_t duty)
+{
+  if(channel >= BCM_CHANNELS || this->_duty[channel] == duty)
+  {
+    return;
+  }
+  this->_duty[channel] = duty;
+  this->_dirty = true;
+}
+
+/**
+ * Builds the masks of the duties written since the previous commit, they are
+ * applied from the next period.
+ */
+void BcmOutput::commit(void)
+{
+  if(this->_dirty)
+  {
+    this->_dirty = false;
+    this->build();
+  }
+}
+
+/**
+ * Builds the port masks of the bit planes into the buffer that is not in
+ * use, bit k of a duty sets the bit of its channel in the mask of plane k.
+ */
+void BcmOutput::build(void)
+{
+  // While there is no swap pending the interruption keeps its buffer
+  this->_pending = false;
+  uint8_t *planes = this->_planes[this->_active ^ 1];
+  for(uint8_t plane = 0; plane < BCM_PLANES; plane++)
+  {
+    planes[plane] = 0;
+  }
+  for(uint8_t channel = 0; channel < BCM_CHANNELS; channel++)
+  {
+    uint8_t bit = 1 << channel;
+    if(!(this->_channels & bit))
+    {
+      continue;
+    }
+    uint8_t duty = this->_duty[channel];
+    for(uint8_t plane = 0; duty != 0; plane++)
+    {
+      if(duty & 0x01)
+      {
+        planes[plane] |= bit;
+      }
+      duty >>= 1;
+    }
+  }
+  // The masks must be complete in memory before they are handed over
+  __asm__ __volatile__("" ::: "memory");
+  this->_pending = true;
+}
+
+/**
+ * Called by the timer at the end of each interval. Outputs the mask of the
+ * next bit plane and sets the length of its interval (2^plane ticks), the
+ * new masks are swapped in before the first plane.
+ */
+void BcmOutput::nextPlane(void)
+{
+  uint8_t plane = this->_plane;
+  if(plane == 0 && this->_pending)
+  {
+    this->_active ^= 1;
+    this->_pending = false;
+  }
+  *this->_port = (*this->_port & ~this->_channels) |
+    this->_planes[this->_active][plane];
+#if defined(__AVR__)
+  uint8_t top = (1 << plane) - 1;
+#if defined(__AVR_ATtiny85__)
+  OCR1C = top;
+#endif
+  OCR1A = top;
+#endif
+  this->_plane = (plane + 1) & (BCM_PLANES - 1);
+}
+
+#if defined(BCM_OUTPUT_TIMER1)
+ISR(TIMER1_COMPA_vect)
+{
+  if(bcm_output_instance != nullptr)
+  {
+    bcm_output_instance->nextPlane();
+  }
+}
+#endif
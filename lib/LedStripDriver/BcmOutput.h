@@ -0,0 +1,61 @@
+/*
+ * BcmOutput.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "LedOutput.h"
+
+#ifndef BCM_OUTPUT_H_
+#define BCM_OUTPUT_H_
+
+// One channel for each bit of the port
+#define BCM_CHANNELS 8
+// One bit plane for each bit of the duty
+#define BCM_PLANES 8
+
+/**
+ * BcmOutput drives up to 8 bits of a port with Binary Code Modulation on
+ * Timer1. The period is split into 8 intervals of 1, 2, 4 ... 128 ticks and
+ * during interval k the channels with bit k of their duty set are on, so
+ * there are always 8 interruptions per period whatever the duties are, and
+ * each one is a single store of a precomputed port mask. write() only keeps
+ * the duty, the masks of the bit planes are built once in commit() for all
+ * the channels written and swapped in at the start of the next period.
+ * The channels are the bits of the port (on the Digispark channel n is Pn).
+ * The period is 255 ticks of F_CPU / 128 on the ATtiny85 (~505 Hz at
+ * 16.5 MHz) and of F_CPU / 256 on others (~245 Hz at 16 MHz).
+ * It takes over Timer1 like SoftPwm, only one of them can be used. The
+ * hardware PWM of P4 is lost and the core must keep millis() on Timer0.
+ */
+class BcmOutput : public LedOutput
+{
+  private:
+    volatile uint8_t *_port;
+    volatile uint8_t *_ddr;
+    uint8_t _channels = 0;
+    uint8_t _duty[BCM_CHANNELS];
+    bool _dirty = false;
+
+    // Double buffered bit planes, _active is used by the interruption
+    uint8_t _planes[2][BCM_PLANES];
+    volatile uint8_t _active = 0;
+    volatile bool _pending = false;
+    uint8_t _plane = 0;
+
+    void build(void);
+
+  public:
+    BcmOutput(volatile uint8_t *port, volatile uint8_t *ddr);
+    void begin(void);
+    void end(void);
+    void setup(uint8_t channel);
+    void write(uint8_t channel, uint8_t duty);
+    void commit(void);
+    void nextPlane(void);
+};
+
+#endif /* BCM_OUTPUT_H_ */
@@ -0,0 +1,40 @@
+/*
+ * BoardOutput.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "BoardProfile.h"
+#include "LedOutput.h"
+#include "SoftPwm.h"
+#include "BcmOutput.h"
+
+#ifndef BOARD_OUTPUT_H_
+#define BOARD_OUTPUT_H_
+
+/*
+ * BoardOutput is the output backend selected by the profile of the board
+ * (LED_OUTPUT_BACKEND) and BOARD_CHANNEL() gives the channel of a LED pin on
+ * it: the pin itself for LedOutput, the bit of the port for the engines.
+ * The engines are started with begin().
+ */
+#if LED_OUTPUT_BACKEND == LED_OUTPUT_SOFT_PWM
+typedef SoftPwm BoardOutput;
+#define BOARD_OUTPUT_ENGINE
+#elif LED_OUTPUT_BACKEND == LED_OUTPUT_BCM
+typedef BcmOutput BoardOutput;
+#define BOARD_OUTPUT_ENGINE
+#else
+typedef LedOutput BoardOutput;
+#endif
+
+#ifdef BOARD_OUTPUT_ENGINE
+#define BOARD_CHANNEL(pin) ((pin) - BOARD_LED_PORT_PIN0)
+#else
+#define BOARD_CHANNEL(pin) (pin)
+#endif
+
+#endif /* BOARD_OUTPUT_H_ */
@@ -0,0 +1,124 @@
+/*
+ * BoardProfile.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#ifndef BOARD_PROFILE_H_
+#define BOARD_PROFILE_H_
+
+// Output backends of the LEDs (see LedOutput, SoftPwm and BcmOutput)
+#define LED_OUTPUT_PINS 0
+#define LED_OUTPUT_SOFT_PWM 1
+#define LED_OUTPUT_BCM 2
+
+/*
+ * Profile of each supported board:
+ *  - BOARD_NAME: name of the target.
+ *  - BOARD_SRAM: bytes of SRAM.
+ *  - BOARD_*_PIN: pins of the LEDs, the mode button (on port B) and the
+ *    analog input of the potentiometer.
+ *  - BOARD_LDR_PIN: analog input of the light sensor of the auto-brightness,
+ *    only when the board has a free one.
+ *  - BOARD_PWM_PINS: mask of the pins with hardware PWM (bit n for pin n).
+ *  - BOARD_LED_PORT, BOARD_LED_DDR, BOARD_LED_PORT_PIN0: port of the LED
+ *    pins and the pin number of its bit 0, only when all the LED pins are on
+ *    the same port and Timer1 is free, so SoftPwm and BcmOutput can be used.
+ *  - BOARD_SCAN_DELAY, BOARD_FRAME_DELAY, BOARD_STROBE_DELAY: milliseconds
+ *    between two scans of the buttons, two frames of the LEDs and two changes
+ *    of the strobe.
+ *
+ * Timers: Timer0 belongs to the core, it counts millis() and delay() (the
+ * Digistump core is used with millis on Timer0) and gives the hardware PWM of
+ * P0 and P1 on the Digispark, of pins 5 and 6 on the ATmega. Timer1 gives the
+ * hardware PWM of P4 on the Digispark and of pins 9 and 10 on the ATmega,
+ * unless SoftPwm or BcmOutput takes it over for the LEDs. Timer2 of the
+ * ATmega gives the PWM of pin 11. The watchdog wakes SoftRTC.
+ */
+#if defined(__AVR_ATtiny85__)
+// Digispark (ATtiny85 at 16.5 MHz)
+#define BOARD_NAME "digispark-tiny"
+#define BOARD_SRAM 512
+#define BOARD_RED_PIN 0
+#define BOARD_GREEN_PIN 1
+#define BOARD_BTN_MODE_PIN 2
+#define BOARD_BLUE_PIN 3
+#define BOARD_WHITE_PIN 4
+#define BOARD_POT_PIN 0
+// All the pins are used, there is no analog input for a light sensor
+#define BOARD_PWM_PINS 0x13UL
+#define BOARD_LED_PORT PORTB
+#define BOARD_LED_DDR DDRB
+#define BOARD_LED_PORT_PIN0 0
+#define BOARD_SCAN_DELAY 10
+#define BOARD_FRAME_DELAY 20
+#define BOARD_STROBE_DELAY 200
+#elif defined(__AVR_ATmega168__) || defined(__AVR_ATmega328P__)
+// Arduino Pro / Pro Mini (ATmega168 or ATmega328P at 16 MHz), Timer1 drives
+// the PWM of red and green so the LED pins are not given to the engines
+#define BOARD_NAME "pro16MHzatmega168"
+#define BOARD_SRAM (RAMEND - RAMSTART + 1)
+#define BOARD_RED_PIN 9
+#define BOARD_GREEN_PIN 10
+#define BOARD_BLUE_PIN 11
+#define BOARD_WHITE_PIN 6
+#define BOARD_BTN_MODE_PIN 12
+#define BOARD_POT_PIN 0
+#define BOARD_LDR_PIN 1
+#define BOARD_PWM_PINS 0xE68UL
+#define BOARD_SCAN_DELAY 10
+#define BOARD_FRAME_DELAY 10
+#define BOARD_STROBE_DELAY 200
+#elif !defined(__AVR__)
+// Host build of the tests (native env), the pins of the Digispark on the
+// Arduino API of test/host, with a light sensor
+#define BOARD_NAME "native"
+#define BOARD_SRAM 512
+#define BOARD_RED_PIN 0
+#define BOARD_GREEN_PIN 1
+#define BOARD_BTN_MODE_PIN 2
+#define BOARD_BLUE_PIN 3
+#define BOARD_WHITE_PIN 4
+#define BOARD_POT_PIN 0
+#define BOARD_LDR_PIN 1
+#define BOARD_PWM_PINS 0x1FUL
+#define BOARD_SCAN_DELAY 10
+#define BOARD_FRAME_DELAY 20
+#define BOARD_STROBE_DELAY 200
+#else
+#error "No board profile for this target, add one to BoardProfile.h"
+#endif
+
+#define BOARD_CLOCK F_CPU
+#define BOARD_HAS_PWM(pin) ((BOARD_PWM_PINS >> (pin)) & 1)
+
+// The best backend: the pins when all the LEDs have hardware PWM, otherwise
+// the BCM engine (constant cost, 8 bits on every pin) when it can be used.
+#if BOARD_HAS_PWM(BOARD_RED_PIN) && BOARD_HAS_PWM(BOARD_GREEN_PIN) && \
+  BOARD_HAS_PWM(BOARD_BLUE_PIN) && BOARD_HAS_PWM(BOARD_WHITE_PIN)
+#define BOARD_DEFAULT_OUTPUT LED_OUTPUT_PINS
+#elif defined(BOARD_LED_PORT)
+#define BOARD_DEFAULT_OUTPUT LED_OUTPUT_BCM
+#else
+#define BOARD_DEFAULT_OUTPUT LED_OUTPUT_PINS
+#endif
+
+// It can be forced with a build flag: -D LED_OUTPUT_BACKEND=LED_OUTPUT_SOFT_PWM
+#ifndef LED_OUTPUT_BACKEND
+#define LED_OUTPUT_BACKEND BOARD_DEFAULT_OUTPUT
+#endif
+
+#if LED_OUTPUT_BACKEND != LED_OUTPUT_PINS && !defined(BOARD_LED_PORT)
+#error "The LED pins of this board can not be driven by SoftPwm or BcmOutput"
+#endif
+
+// The tiny cores can move millis() to Timer1, then it is not free for the
+// engines (seen in the files that include Arduino.h first)
+#if LED_OUTPUT_BACKEND != LED_OUTPUT_PINS && defined(TIMER_TO_USE_FOR_MILLIS) && \
+  TIMER_TO_USE_FOR_MILLIS == 1
+#error "millis() runs on Timer1, SoftPwm and BcmOutput need it"
+#endif
+
+#endif /* BOARD_PROFILE_H_ */
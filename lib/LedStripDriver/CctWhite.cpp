@@ -0,0 +1,145 @@
+/*
+ * CctWhite.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "CctWhite.h"
+#include "ColorMath.h"
+#include <Arduino.h>
+
+// Mix of white, red and green for each CCT_STEP from CCT_MIN to CCT_MAX,
+// blue is never needed on top of a cold white.
+static const uint8_t CCT_TABLE[][3] PROGMEM = {
+  { 39, 216, 107 }, { 50, 205, 101 }, { 61, 194, 94 }, { 70, 185, 89 },     // 2200 K
+  { 79, 176, 84 }, { 87, 168, 80 }, { 95, 160, 75 }, { 103, 152, 71 },      // 2600 K
+  { 110, 145, 67 }, { 117, 138, 63 }, { 123, 132, 61 }, { 129, 126, 58 },   // 3000 K
+  { 135, 120, 55 }, { 141, 114, 52 }, { 146, 109, 49 }, { 151, 104, 47 },   // 3400 K
+  { 157, 98, 44 }, { 161, 94, 42 }, { 166, 89, 40 }, { 171, 84, 37 },       // 3800 K
+  { 175, 80, 36 }, { 179, 76, 34 }, { 183, 72, 32 }, { 187, 68, 31 },       // 4200 K
+  { 191, 64, 29 }, { 195, 60, 27 }, { 199, 56, 25 }, { 202, 53, 24 },       // 4600 K
+  { 206, 49, 22 }, { 209, 46, 21 }, { 213, 42, 19 }, { 216, 39, 18 },       // 5000 K
+  { 219, 36, 17 }, { 222, 33, 15 }, { 225, 30, 14 }, { 228, 27, 13 },       // 5400 K
+  { 231, 24, 12 }, { 234, 21, 10 }, { 237, 18, 9 }, { 240, 15, 8 },         // 5800 K
+  { 242, 13, 7 }, { 245, 10, 6 }, { 248, 7, 5 }, { 250, 5, 4 }              // 6200 K
+};
+
+/**
+ * Constructor of the class.
+ * @param rgb RGB LEDs used to tint the white
+ * @param white White LEDs
+ */
+CctWhite::CctWhite(LedStripRGB &rgb, LedStrip &white) : _rgb(rgb), _white(white)
+{
+}
+
+/**
+ * Turns on the mix of the current temperature and brightness, the color and
+ * the mode of the RGB LEDs are kept for disable().
+ */
+void CctWhite::enable(void)
+{
+  if(!this->_enabled)
+  {
+    this->_rgb_color = this->_rgb.getColor();
+    this->_rgb_mode = this->_rgb.getMode();
+    this->_enabled = true;
+  }
+  this->_rgb.setMode(LedStripRgbMode::NORMAL);
+  this->apply();
+}
+
+/**
+ * Stops following the temperature. The white LEDs get back their whole
+ * intensity and the RGB LEDs their color and mode, their states are kept.
+ */
+void CctWhite::disable(void)
+{
+  if(!this->_enabled)
+  {
+    return;
+  }
+  this->_enabled = false;
+  this->_white.setMixScale(255);
+  this->_rgb.setColor(this->_rgb_color);
+  this->_rgb.setMode(this->_rgb_mode);
+}
+
+bool CctWhite::isEnabled(void)
+{
+  return this->_enabled;
+}
+
+/**
+ * Writes the mix of the table to the LEDs, scaled by the brightness. The
+ * white LEDs keep their intensity, so the tint is also scaled by it.
+ */
+void CctWhite::apply(void)
+{
+  if(!this->_enabled)
+  {
+    return;
+  }
+  const uint8_t *mix = CCT_TABLE[(this->_kelvin - CCT_MIN) / CCT_STEP];
+  uint8_t tint = scale8(this->_brightness, this->_white.getIntensity());
+  uint8_t red = scale8(pgm_read_byte(&mix[1]), tint);
+  uint8_t green = scale8(pgm_read_byte(&mix[2]), tint);
+  this->_white.setMixScale(scale8(pgm_read_byte(&mix[0]), this->_brightness));
+  this->_rgb.setColor(((uint32_t)red << 16) | ((uint16_t)green << 8));
+  this->_rgb.setState(red != 0 || green != 0 ? LedStripState::ON : LedStripState::OFF);
+}
+
+/**
+ * Sets the color temperature, it is applied at once if the mode is enabled.
+ * @param kelvin Temperature in Kelvin, limited to CCT_MIN - CCT_MAX
+ */
+void CctWhite::setTemperature(uint16_t kelvin)
+{
+  kelvin = constrain(kelvin, CCT_MIN, CCT_MAX);
+  if(kelvin != this->_kelvin)
+  {
+    this->_kelvin = kelvin;
+    this->apply();
+  }
+}
+
+uint16_t CctWhite::getTemperature(void)
+{
+  return this->_kelvin;
+}
+
+/**
+ * Sets the brightness of the mix, it is applied at once if the mode is
+ * enabled.
+ * @param brightness Brightness (0 - 255)
+ */
+void CctWhite::setBrightness(uint8_t brightness)
+{
+  if(brightness != this->_brightness)
+  {
+    this->_brightness = brightness;
+    this->apply();
+  }
+}
+
+uint8_t CctWhite::getBrightness(void)
+{
+  return this->_brightness;
+}
+
+/**
+ * Color of the RGB LEDs before the mix, the one that disable() restores.
+ */
+uint32_t CctWhite::getRgbColor(void)
+{
+  return this->_enabled ? this->_rgb_color : this->_rgb.getColor();
+}
+
+/**
+ * Mode of the RGB LEDs before the mix, the one that disable() restores.
+ */
+LedStripRgbMode CctWhite::getRgbMode(void)
+{
+  return this->_enabled ? this->_rgb_mode : this->_rgb.getMode();
+}
@@ -0,0 +1,60 @@
+/*
+ * CctWhite.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "LedStrip.h"
+#include "LedStripRGB.h"
+
+#ifndef CCT_WHITE_H_
+#define CCT_WHITE_H_
+
+// Range of color temperatures in Kelvin and step of the table
+#define CCT_MIN 2200
+#define CCT_MAX 6500
+#define CCT_STEP 100
+#define CCT_DEFAULT 2700
+
+/**
+ * CctWhite shows a white light of a given color temperature (2200 - 6500 K)
+ * mixing the white LEDs with the RGB LEDs. The white LEDs are taken as a cold
+ * white (~6500 K): the part of the target color common to the three channels
+ * goes to the white LEDs and the rest is added with red and green. The mix of
+ * each temperature comes from a table in the flash memory (PROGMEM), so the
+ * changes only cost a lookup and two scales.
+ * The intensity of the white LEDs is kept, the mix takes a part of it with
+ * the mix scale of the strip, and the color and mode of the RGB LEDs are
+ * given back when the mode is disabled.
+ */
+class CctWhite
+{
+  private:
+    LedStripRGB &_rgb;
+    LedStrip &_white;
+    uint16_t _kelvin = CCT_DEFAULT;
+    uint8_t _brightness = 255;
+    bool _enabled = false;
+    // Color and mode of the RGB LEDs before the mix
+    uint32_t _rgb_color;
+    LedStripRgbMode _rgb_mode;
+
+    void apply(void);
+
+  public:
+    CctWhite(LedStripRGB &rgb, LedStrip &white);
+    void enable(void);
+    void disable(void);
+    bool isEnabled(void);
+    void setTemperature(uint16_t);
+    uint16_t getTemperature(void);
+    void setBrightness(uint8_t);
+    uint8_t getBrightness(void);
+    uint32_t getRgbColor(void);
+    LedStripRgbMode getRgbMode(void);
+};
+
+#endif /* CCT_WHITE_H_ */
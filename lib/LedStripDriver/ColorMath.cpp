@@ -0,0 +1,57 @@
+/*
+ * ColorMath.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "ColorMath.h"
+
+/**
+ * Scales a value by a fraction of 256, 255 keeps the value unchanged.
+ * @param value Value to scale
+ * @param scale Fraction (0 - 255)
+ */
+uint8_t scale8(uint8_t value, uint8_t scale)
+{
+  return ((uint16_t)value * (scale + 1)) >> 8;
+}
+
+/**
+ * Scales the three channels of a color.
+ * @param color Color in hexadecimal format
+ * @param scale Fraction (0 - 255)
+ */
+uint32_t scaleColor(uint32_t color, uint8_t scale)
+{
+  return ((uint32_t)scale8(color >> 16, scale) << 16) |
+    ((uint16_t)scale8(color >> 8, scale) << 8) |
+    scale8(color, scale);
+}
+
+/**
+ * Blends two colors channel by channel.
+ * @param from Color when amount is 0
+ * @param to Color when amount is 255
+ * @param amount Fraction of the second color (0 - 255)
+ */
+uint32_t blendColor(uint32_t from, uint32_t to, uint8_t amount)
+{
+  return scaleColor(from, 255 - amount) + scaleColor(to, amount);
+}
+
+/**
+ * Adds two colors channel by channel, saturating at 255.
+ * @param a First color
+ * @param b Second color
+ */
+uint32_t addColor(uint32_t a, uint32_t b)
+{
+  uint32_t result = 0;
+  for(uint8_t shift = 0; shift < 24; shift += 8)
+  {
+    uint16_t sum = (uint8_t)(a >> shift) + (uint8_t)(b >> shift);
+    result |= (uint32_t)(sum > 255 ? 255 : sum) << shift;
+  }
+  return result;
+}
@@ -0,0 +1,19 @@
+/*
+ * ColorMath.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef COLOR_MATH_H_
+#define COLOR_MATH_H_
+
+uint8_t scale8(uint8_t, uint8_t);
+uint32_t scaleColor(uint32_t, uint8_t);
+uint32_t blendColor(uint32_t, uint32_t, uint8_t);
+uint32_t addColor(uint32_t, uint32_t);
+
+#endif /* COLOR_MATH_H_ */
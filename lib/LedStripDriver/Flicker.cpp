@@ -0,0 +1,104 @@
+/*
+ * Flicker.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "Flicker.h"
+#include "ColorMath.h"
+
+/**
+ * Constructor of the class.
+ * @param seed Initial state of the LFSR, different seeds for different strips
+ */
+Flicker::Flicker(uint16_t seed) : _lfsr(seed)
+{
+}
+
+/**
+ * Obtains 8 new random bits. Consecutive states of the LFSR are shifted
+ * copies of each other, so it advances one step for each bit.
+ */
+uint8_t Flicker::random8(void)
+{
+  for(uint8_t i = 0; i < 7; i++)
+  {
+    this->_lfsr.next();
+  }
+  return this->_lfsr.next();
+}
+
+/**
+ * Draws a new target for the style and moves the level towards it.
+ */
+void Flicker::update(FlickerStyle style)
+{
+  uint8_t noise = this->random8();
+  uint8_t target;
+  uint8_t shift;
+  switch (style) {
+    case FlickerStyle::FLICKER_CANDLE:
+      // One update out of 32 is a draft that dips the flame
+      target = noise < 8 ? 96 + (this->random8() >> 2) : 192 + (noise >> 2);
+      shift = 2;
+      break;
+    case FlickerStyle::FLICKER_FIRE:
+      target = 64 + scale8(noise, 191);
+      shift = 1;
+      break;
+    case FlickerStyle::FLICKER_TWINKLE:
+      if(noise < 6)
+      {
+        this->_sparkle = 255;
+      }
+      else
+      {
+        this->_sparkle -= this->_sparkle >> 2;
+      }
+      target = 176 + scale8(this->_sparkle, 79);
+      shift = 1;
+      break;
+    default:
+      target = 255;
+      shift = 0;
+  }
+  uint16_t goal = (uint16_t)target << 8;
+  if(goal > this->_level)
+  {
+    this->_level += (goal - this->_level) >> shift;
+  }
+  else
+  {
+    this->_level -= (this->_level - goal) >> shift;
+  }
+}
+
+/**
+ * Advances the noise by the elapsed time.
+ * @param style Character of the noise
+ * @param elapsed Milliseconds since the previous step
+ * @return true if the level changed
+ */
+bool Flicker::step(FlickerStyle style, uint16_t elapsed)
+{
+  uint8_t level = this->getLevel();
+  uint8_t updates = 0;
+  elapsed += this->_elapsed;
+  while(elapsed >= FLICKER_STEP && updates < FLICKER_MAX_UPDATES)
+  {
+    this->update(style);
+    elapsed -= FLICKER_STEP;
+    updates++;
+  }
+  this->_elapsed = elapsed < FLICKER_STEP ? elapsed : 0;
+  return this->getLevel() != level;
+}
+
+/**
+ * It allows to obtain the current brightness level (0 - 255).
+ */
+uint8_t Flicker::getLevel(void)
+{
+  return this->_level >> 8;
+}
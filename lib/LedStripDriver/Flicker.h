@@ -0,0 +1,57 @@
+/*
+ * Flicker.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "Lfsr.h"
+
+#ifndef FLICKER_H_
+#define FLICKER_H_
+
+/**
+ * Character of the noise of a Flicker.
+ */
+enum FlickerStyle
+{
+  FLICKER_NONE,
+  FLICKER_CANDLE,
+  FLICKER_FIRE,
+  FLICKER_TWINKLE
+};
+
+// Milliseconds between two updates of the noise
+#define FLICKER_STEP 20
+// Maximum number of updates run by a single step
+#define FLICKER_MAX_UPDATES 4
+
+/**
+ * Flicker generates an organic brightness level (0 - 255) from the noise of
+ * a 16 bits LFSR filtered with a first order low pass in 8.8 fixed point.
+ * The noise is updated every FLICKER_STEP milliseconds whatever the rate of
+ * the calls, so the character does not depend on the frame rate.
+ *  - CANDLE: slow wavering near full brightness with occasional dips.
+ *  - FIRE: fast and deep flickering.
+ *  - TWINKLE: steady level with short sparkles that decay.
+ */
+class Flicker
+{
+  private:
+    Lfsr _lfsr;
+    uint16_t _level = 0xFF00;
+    uint8_t _sparkle = 0;
+    uint8_t _elapsed = 0;
+
+    uint8_t random8(void);
+    void update(FlickerStyle);
+
+  public:
+    Flicker(uint16_t seed = 0xACE1);
+    bool step(FlickerStyle, uint16_t);
+    uint8_t getLevel(void);
+};
+
+#endif /* FLICKER_H_ */
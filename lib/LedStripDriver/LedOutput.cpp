@@ -0,0 +1,38 @@
+/*
+ * LedOutput.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "LedOutput.h"
+#include <Arduino.h>
+
+LedOutput pin_output;
+
+/**
+ * Set the pin of the channel as an output.
+ * @param channel Pin of the channel
+ */
+void LedOutput::setup(uint8_t channel)
+{
+  pinMode(channel, OUTPUT);
+}
+
+/**
+ * Writes the duty of a channel to its pin.
+ * @param channel Pin of the channel
+ * @param duty Duty of the channel (0 - 255)
+ */
+void LedOutput::write(uint8_t channel, uint8_t duty)
+{
+  analogWrite(channel, duty);
+}
+
+/**
+ * Applies the writes since the previous commit, the pins apply each write at
+ * once.
+ */
+void LedOutput::commit(void)
+{
+}
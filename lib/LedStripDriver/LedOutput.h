@@ -0,0 +1,36 @@
+/*
+ * LedOutput.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef LED_OUTPUT_H_
+#define LED_OUTPUT_H_
+
+/**
+ * LedOutput is used by the strips to write the duty of their logical
+ * channels, so a strip does not need to know how a channel reaches the LEDs.
+ * This implementation takes each channel as the pin with the same number and
+ * writes it with analogWrite(), on pins without hardware PWM the duty is
+ * rounded to on/off. Other engines (software PWM, shift registers) override
+ * setup() and write().
+ * The duty is 0 for fully off and 255 for fully on, the strips apply their
+ * polarity before the write. After the channels of a color the strips call
+ * commit(), so an engine can prepare its output once for all of them.
+ */
+class LedOutput
+{
+  public:
+    virtual void setup(uint8_t channel);
+    virtual void write(uint8_t channel, uint8_t duty);
+    virtual void commit(void);
+};
+
+// Output to the pins used by the strips by default
+extern LedOutput pin_output;
+
+#endif /* LED_OUTPUT_H_ */
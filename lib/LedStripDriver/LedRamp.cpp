@@ -0,0 +1,129 @@
+/*
+ * LedRamp.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "LedRamp.h"
+
+/**
+ * Allows to set the duration of a ramp over the full scale (0 to 255). In
+ * SMOOTH mode it is about four time constants.
+ * @param time Duration in milliseconds, 0 for immediate changes
+ */
+void LedRamp::setTime(uint16_t time)
+{
+  if(time == 0)
+  {
+    this->_rate = 0;
+    this->_smooth = 0;
+    this->jumpTo(this->_target);
+    return;
+  }
+  // Rounded to the nearest, a truncated rate makes the long ramps late
+  this->_rate = ((255UL << 8) + time / 2) / time;
+  if(this->_rate == 0)
+  {
+    this->_rate = 1;
+  }
+  this->_smooth = (4UL << 10) / time;
+  if(this->_smooth == 0)
+  {
+    this->_smooth = 1;
+  }
+}
+
+void LedRamp::setEase(LedRampEase ease)
+{
+  this->_ease = ease;
+}
+
+/**
+ * Starts a ramp from the current value to the target.
+ */
+void LedRamp::setTarget(uint8_t target)
+{
+  this->_target = target;
+  if(this->_rate == 0)
+  {
+    this->jumpTo(target);
+  }
+}
+
+/**
+ * Sets the value and the target without a ramp.
+ */
+void LedRamp::jumpTo(uint8_t value)
+{
+  this->_target = value;
+  this->_value = (uint16_t)value << 8;
+  this->_output = value;
+}
+
+uint8_t LedRamp::getTarget(void)
+{
+  return this->_target;
+}
+
+/**
+ * It allows to obtain the current duty of the ramp.
+ */
+uint8_t LedRamp::getValue(void)
+{
+  return this->_output;
+}
+
+bool LedRamp::isRunning(void)
+{
+  return this->_value != ((uint16_t)this->_target << 8);
+}
+
+/**
+ * Advances the ramp.
+ * @param elapsed Milliseconds since the last step
+ * @return true if the 8 bits output changed
+ */
+bool LedRamp::step(uint16_t elapsed)
+{
+  uint16_t target = (uint16_t)this->_target << 8;
+  if(this->_value == target)
+  {
+    return false;
+  }
+  if(elapsed > LED_RAMP_MAX_STEP)
+  {
+    elapsed = LED_RAMP_MAX_STEP;
+  }
+  bool up = target > this->_value;
+  uint16_t distance = up ? target - this->_value : this->_value - target;
+  uint32_t delta;
+  if(this->_ease == LedRampEase::SMOOTH)
+  {
+    uint32_t factor = (uint32_t)this->_smooth * elapsed;
+    delta = factor >= 1024 ? distance : ((uint32_t)distance * factor) >> 10;
+    if(delta < 16)
+    {
+      delta = 16;
+    }
+  }
+  else
+  {
+    delta = (uint32_t)this->_rate * elapsed;
+  }
+  if(delta >= distance)
+  {
+    this->_value = target;
+  }
+  else
+  {
+    this->_value = up ? this->_value + delta : this->_value - delta;
+  }
+  uint8_t output = this->_value >> 8;
+  if(output == this->_output)
+  {
+    return false;
+  }
+  this->_output = output;
+  return true;
+}
@@ -0,0 +1,55 @@
+/*
+ * LedRamp.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef LED_RAMP_H_
+#define LED_RAMP_H_
+
+// Longest time advanced by a single step, in milliseconds
+#define LED_RAMP_MAX_STEP 100
+
+/**
+ * Shape of the ramp.
+ *  - LINEAR: constant speed until the target is reached.
+ *  - SMOOTH: fast at first and slower near the target (exponential approach).
+ */
+enum LedRampEase
+{
+  LINEAR,
+  SMOOTH
+};
+
+/**
+ * LedRamp moves the duty of a channel towards a target at a limited rate, so
+ * the changes of brightness do not pop. The value is kept in 8.8 fixed point,
+ * the 8 bits output is a single byte that can be read from an interruption.
+ * A ramp time of 0 (the default) makes the changes immediate.
+ */
+class LedRamp
+{
+  private:
+    uint16_t _value = 0;
+    volatile uint8_t _output = 0;
+    uint8_t _target = 0;
+    uint16_t _rate = 0;
+    uint16_t _smooth = 0;
+    LedRampEase _ease = LedRampEase::LINEAR;
+
+  public:
+    void setTime(uint16_t);
+    void setEase(LedRampEase);
+    void setTarget(uint8_t);
+    void jumpTo(uint8_t);
+    uint8_t getTarget(void);
+    uint8_t getValue(void);
+    bool isRunning(void);
+    bool step(uint16_t);
+};
+
+#endif /* LED_RAMP_H_ */
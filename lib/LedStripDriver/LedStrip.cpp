@@ -6,6 +6,7 @@
  * http://creativecommons.org/licenses/by/4.0/
  */
 #include "LedStrip.h"
+#include "ColorMath.h"
 #include <Arduino.h>
 
 /**
@@ -13,16 +14,28 @@
  * @param pin Pin of exit towards the led strip
  */
 LedStrip::LedStrip(uint8_t pin)
+  : LedStrip(pin, pin_output)
 {
-  this->_pin = pin;
 }
 
 /**
- * Set the controller pin as an output.
+ * Constructor of the class for a strip on a logical channel of an output.
+ * @param channel Channel of the output
+ * @param output Output that drives the channel
+ */
+LedStrip::LedStrip(uint8_t channel, LedOutput &output)
+{
+  this->_channel = channel;
+  this->_output = &output;
+}
+
+/**
+ * Set the channel of the strip as an output.
  */
 void LedStrip::setup(void)
 {
-  pinMode(this->_pin, OUTPUT);
+  this->_output->setup(this->_channel);
+  this->update();
 }
 
 /**
@@ -32,7 +45,47 @@ void LedStrip::setup(void)
  */
 void LedStrip::setCommonAnodeEnable(bool enabled)
 {
-  this->_common_anode = enabled;
+  if(enabled != this->_common_anode)
+  {
+    this->_common_anode = enabled;
+    this->update();
+  }
+}
+
+/**
+ * Writes the current value of the ramp to the pin. When the ramp reaches zero
+ * on the off state the pin is left at its idle level.
+ */
+void LedStrip::update(void)
+{
+  uint8_t duty = this->_ramp.getValue();
+  if(duty == 0 && !this->_state)
+  {
+    this->_output->write(this->_channel, this->_common_anode ? 255 : 0);
+    this->_output->commit();
+    return;
+  }
+  if(this->_flicker_style != FlickerStyle::FLICKER_NONE)
+  {
+    duty = scale8(duty, this->_flicker.getLevel());
+  }
+  if(this->_mix_scale < 255)
+  {
+    duty = scale8(duty, this->_mix_scale);
+  }
+  if(this->_output_scale < 255)
+  {
+    duty = scale8(duty, this->_output_scale);
+  }
+  if(this->_common_anode)
+  {
+    this->_output->write(this->_channel, 255 - duty);
+  }
+  else
+  {
+    this->_output->write(this->_channel, duty);
+  }
+  this->_output->commit();
 }
 
 /**
@@ -46,15 +99,9 @@ void LedStrip::turnOn(void)
     {
       this->_intensity = 255;
     }
-    if(this->_common_anode)
-    {
-      analogWrite(this->_pin, 255 - this->_intensity);
-    }
-    else
-    {
-      analogWrite(this->_pin, this->_intensity);
-    }
     this->_state = true;
+    this->_ramp.setTarget(this->_intensity);
+    this->update();
   }
 }
 
@@ -65,15 +112,9 @@ void LedStrip::turnOff(void)
 {
   if(this->_state)
   {
-    if(this->_common_anode)
-    {
-      digitalWrite(this->_pin, HIGH);
-    }
-    else
-    {
-      digitalWrite(this->_pin, LOW);
-    }
     this->_state = false;
+    this->_ramp.setTarget(0);
+    this->update();
   }
 }
 
@@ -136,16 +177,10 @@ void LedStrip::setIntensity(uint8_t intensity)
   }
   else if(this->_state)
   {
-    if(this->_common_anode)
-    {
-      analogWrite(this->_pin, 255 - this->_intensity);
-    }
-    else
-    {
-      analogWrite(this->_pin, this->_intensity);
-    }
+    this->_ramp.setTarget(this->_intensity);
+    this->update();
   }
-  else
+  else if(intensity > 0)
   {
     this->turnOn();
   }
@@ -157,4 +192,134 @@ void LedStrip::setIntensity(uint8_t intensity)
 uint8_t LedStrip::getIntensity(void)
 {
   return this->_intensity;
-}
\ No newline at end of file
+}
+
+/**
+ * Allows to make the changes of brightness gradual, including turning on and
+ * off. By default the changes are immediate (0).
+ * @param time Milliseconds of a ramp over the full scale
+ */
+void LedStrip::setRampTime(uint16_t time)
+{
+  this->_ramp.setTime(time);
+  this->update();
+}
+
+/**
+ * Allows to choose the shape of the ramps (LINEAR or SMOOTH).
+ */
+void LedStrip::setRampEase(LedRampEase ease)
+{
+  this->_ramp.setEase(ease);
+}
+
+/**
+ * Allows to take a part of the intensity for a mix with other LEDs (see
+ * CctWhite), so the intensity set by the user is kept. While the LEDs are lit
+ * loop() moves to the new scale one step every LED_MIX_SLEW milliseconds.
+ * @param scale Fraction of the intensity (0 - 255), 255 for the whole
+ */
+void LedStrip::setMixScale(uint8_t scale)
+{
+  this->_mix_target = scale;
+  if(!this->_state && this->_ramp.getValue() == 0)
+  {
+    this->_mix_scale = scale;
+  }
+}
+
+/**
+ * Allows to limit the output without changing the intensity, for example to
+ * keep the current of the strip within the budget of the supply.
+ * @param scale Fraction of the intensity (0 - 255), 255 for no limit
+ */
+void LedStrip::setOutputScale(uint8_t scale)
+{
+  if(scale != this->_output_scale)
+  {
+    this->_output_scale = scale;
+    this->update();
+  }
+}
+
+/**
+ * It allows to obtain the duty requested by the strip (intensity and ramp),
+ * before the output scale is applied. It is 0 when the LEDs are off.
+ */
+uint8_t LedStrip::getDuty(void)
+{
+  return this->_ramp.getValue();
+}
+
+/**
+ * Allows to modulate the brightness with an organic noise (candle, fire or
+ * twinkle), FLICKER_NONE for a steady light. loop() must be called
+ * periodically.
+ */
+void LedStrip::setFlicker(FlickerStyle style)
+{
+  this->_flicker_style = style;
+  this->update();
+}
+
+/**
+ * It allows to obtain the state of the strip, including the point of the
+ * ramp, so it can be restored after a reset.
+ */
+LedStripSnapshot LedStrip::getSnapshot(void)
+{
+  LedStripSnapshot snapshot;
+  snapshot.on = this->_state;
+  snapshot.intensity = this->_intensity;
+  snapshot.duty = this->_ramp.getValue();
+  snapshot.flicker = this->_flicker_style;
+  return snapshot;
+}
+
+/**
+ * Restores the state of getSnapshot() at once, a ramp that was running
+ * continues from the same point.
+ */
+void LedStrip::restoreSnapshot(const LedStripSnapshot &snapshot)
+{
+  this->_state = snapshot.on;
+  this->_intensity = snapshot.intensity;
+  this->_flicker_style = snapshot.flicker <= FlickerStyle::FLICKER_TWINKLE ?
+    static_cast<FlickerStyle>(snapshot.flicker) : FlickerStyle::FLICKER_NONE;
+  this->_ramp.jumpTo(snapshot.duty);
+  this->_ramp.setTarget(snapshot.on ? snapshot.intensity : 0);
+  this->_last_update = millis();
+  this->update();
+}
+
+/**
+ * Advances the ramp of brightness and the flicker, it must be called
+ * periodically when a ramp time or a flicker is set.
+ */
+void LedStrip::loop(void)
+{
+  uint32_t now = millis();
+  uint16_t elapsed = now - this->_last_update > 0xFFFF ? 0xFFFF : now - this->_last_update;
+  this->_last_update = now;
+  bool changed = this->_ramp.step(elapsed);
+  if(this->_mix_scale != this->_mix_target)
+  {
+    bool up = this->_mix_scale < this->_mix_target;
+    uint8_t gap = up ? this->_mix_target - this->_mix_scale : this->_mix_scale - this->_mix_target;
+    uint16_t step = elapsed / LED_MIX_SLEW + 1;
+    if(step > gap)
+    {
+      step = gap;
+    }
+    this->_mix_scale = up ? this->_mix_scale + step : this->_mix_scale - step;
+    changed = true;
+  }
+  if(this->_flicker_style != FlickerStyle::FLICKER_NONE && this->_state)
+  {
+    changed |= this->_flicker.step(this->_flicker_style, elapsed);
+  }
+  if(changed)
+  {
+    this->update();
+  }
+}
@@ -7,6 +7,9 @@
  */
 
 #include <inttypes.h>
+#include "LedRamp.h"
+#include "LedOutput.h"
+#include "Flicker.h"
 
 #ifndef LED_STRIP_H_
 #define LED_STRIP_H_
@@ -23,21 +26,49 @@ enum LedStripState
 #define TURN_ON true
 #define TURN_OFF false
 
+// Milliseconds for each step of the mix scale, a whole change takes ~1 s
+#define LED_MIX_SLEW 4
+
+/**
+ * State of a LedStrip kept across a reset (4 bytes).
+ */
+struct LedStripSnapshot
+{
+  bool on;
+  uint8_t intensity;
+  uint8_t duty;
+  uint8_t flicker;
+};
+
+static_assert(sizeof(LedStripSnapshot) == 4, "LedStripSnapshot is not 4 bytes");
+
 /**
- * LedStrip allows to handle the output to a led strip of a single pin.
+ * LedStrip allows to handle the output to a led strip of a single channel.
  * Its main functions are to turn on or turn off the LEDs and change the
- * intensity of brightness.
+ * intensity of brightness. With a ramp time the changes are gradual and
+ * loop() must be called periodically.
  */
 class LedStrip
 {
   private:
-    uint8_t _pin;
+    uint8_t _channel;
+    LedOutput *_output;
     bool _state = false;
     uint8_t _intensity = 255;
     bool _common_anode = false;
+    LedRamp _ramp;
+    uint8_t _mix_scale = 255;
+    uint8_t _mix_target = 255;
+    uint8_t _output_scale = 255;
+    uint32_t _last_update = 0;
+    FlickerStyle _flicker_style = FlickerStyle::FLICKER_NONE;
+    Flicker _flicker;
+
+    void update(void);
 
   public:
     LedStrip(uint8_t pin);
+    LedStrip(uint8_t channel, LedOutput &output);
     void setup(void);
     void setCommonAnodeEnable(bool);
     void turnOn(void);
@@ -47,6 +78,15 @@ class LedStrip
     LedStripState getState(void);
     void setIntensity(uint8_t);
     uint8_t getIntensity(void);
+    void setRampTime(uint16_t);
+    void setRampEase(LedRampEase);
+    void setMixScale(uint8_t);
+    void setOutputScale(uint8_t);
+    uint8_t getDuty(void);
+    void setFlicker(FlickerStyle);
+    LedStripSnapshot getSnapshot(void);
+    void restoreSnapshot(const LedStripSnapshot&);
+    void loop(void);
 };
 
 #endif /* LED_STRIP_H_ */
\ No newline at end of file
@@ -0,0 +1,417 @@
+/*
+ * LedStripPixels.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "LedStripPixels.h"
+#include "ColorMath.h"
+#include <Arduino.h>
+
+#if defined(__AVR__) && F_CPU < 8000000UL
+#error "LedStripPixels needs a clock of at least 8 MHz"
+#endif
+
+static_assert(PIXELS_FRAME_DELAY == 20, "The speed 0 of the pixels is SPEED_CURVE_20MS");
+static_assert(PIXELS_PHASE_STEPS % FADE_STEPS == 0, "The cycle of the phase must hold whole turns of Fade");
+
+#if defined(__AVR__)
+/**
+ * Sends a byte to the strip, most significant bit first. Each bit takes 20
+ * cycles at 16 MHz (10 cycles at 8 MHz), high for 5 (3) cycles for a zero and
+ * 12 (6) cycles for a one. Interrupts must be disabled by the caller.
+ */
+static inline void sendByte(uint8_t byte, uint8_t hi, uint8_t lo)
+{
+  uint8_t bit = 8;
+  asm volatile(
+    "1:"                    "\n\t"
+    "out %[port], %[hi]"    "\n\t"
+#if F_CPU >= 15000000UL
+    "nop"                   "\n\t"
+    "nop"                   "\n\t"
+#endif
+    "nop"                   "\n\t"
+    "sbrs %[byte], 7"       "\n\t"
+    "out %[port], %[lo]"    "\n\t"
+    "lsl %[byte]"           "\n\t"
+#if F_CPU >= 15000000UL
+    "nop"                   "\n\t"
+    "nop"                   "\n\t"
+    "nop"                   "\n\t"
+    "nop"                   "\n\t"
+#endif
+    "nop"                   "\n\t"
+    "out %[port], %[lo]"    "\n\t"
+#if F_CPU >= 15000000UL
+    "nop"                   "\n\t"
+    "nop"                   "\n\t"
+    "nop"                   "\n\t"
+    "nop"                   "\n\t"
+#endif
+    "dec %[bit]"            "\n\t"
+    "brne 1b"               "\n\t"
+    : [byte] "+r" (byte), [bit] "+r" (bit)
+    : [port] "I" (_SFR_IO_ADDR(PORTB)), [hi] "r" (hi), [lo] "r" (lo)
+  );
+}
+#endif
+
+/**
+ * Constructor of the class.
+ * @param pin Data pin of the strip, it must belong to the port B
+ */
+LedStripPixels::LedStripPixels(uint8_t pin)
+{
+  this->_pin = pin;
+  this->setSpeed(DEFAULT_SPEED);
+}
+
+/**
+ * Set the data pin as an output.
+ */
+void LedStripPixels::setup(void)
+{
+  pinMode(this->_pin, OUTPUT);
+  digitalWrite(this->_pin, LOW);
+  this->_pin_mask = digitalPinToBitMask(this->_pin);
+}
+
+/**
+ * Sends a pixel in the GRB order of the strip. Interrupts are only disabled
+ * while the 24 bits are sent, the pending ones run in the gap between pixels,
+ * which is far below the reset time of the strip.
+ * @param color Color in hexadecimal format
+ */
+void LedStripPixels::sendPixel(uint32_t color)
+{
+#if defined(__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  uint8_t hi = PORTB | this->_pin_mask;
+  uint8_t lo = PORTB & ~this->_pin_mask;
+  sendByte(color >> 8, hi, lo);
+  sendByte(color >> 16, hi, lo);
+  sendByte(color, hi, lo);
+  SREG = sreg;
+#else
+  // The host build of the tests has no strip
+  (void)color;
+#endif
+}
+
+/**
+ * Sends a black frame to the whole strip.
+ */
+void LedStripPixels::sendBlack(void)
+{
+  uint16_t length = this->getLength();
+  for(uint16_t i = 0; i < length; i++)
+  {
+    this->sendPixel(COLOR_BLACK);
+  }
+}
+
+/**
+ * Prepares the state of the pixel generator for the segment, based on the
+ * number of the current frame.
+ */
+void LedStripPixels::beginSegment(const PixelSegment &segment)
+{
+  uint16_t offset;
+  switch (segment.mode) {
+    case LedStripRgbMode::STROBE:
+      this->_cursor_run = (this->_frame / (STROBE_DELAY / PIXELS_FRAME_DELAY)) & 1;
+      break;
+    case LedStripRgbMode::FLASH:
+      offset = this->_phase >> SPEED_CURVE_PHASE_BITS;
+      this->_cursor_position = (offset / PIXELS_CHASE_WIDTH) % FLASH_COLORS_SEQUENCE_LENGTH;
+      this->_cursor_run = PIXELS_CHASE_WIDTH - (offset % PIXELS_CHASE_WIDTH);
+      break;
+    case LedStripRgbMode::FADE:
+      this->_cursor_step = segment.length < FADE_POSITIONS ?
+        FADE_POSITIONS / segment.length : 1;
+      this->_cursor_position = (this->_phase >> (SPEED_CURVE_PHASE_BITS - 8)) % FADE_POSITIONS;
+      break;
+    default:
+      break;
+  }
+  this->_cursor_color = segment.color;
+  this->_cursor_index = 0;
+}
+
+/**
+ * Computes the color of the next pixel of the segment.
+ */
+uint32_t LedStripPixels::nextPixel(const PixelSegment &segment)
+{
+  if(segment.effect != nullptr)
+  {
+    return segment.effect(segment.context, this->_cursor_index++, this->_frame);
+  }
+  uint32_t color;
+  switch (segment.mode) {
+    case LedStripRgbMode::STROBE:
+      this->_cursor_run ^= 1;
+      return this->_cursor_run ? this->_cursor_color : COLOR_BLACK;
+    case LedStripRgbMode::FLASH:
+      color = pgm_read_dword(&FLASH_COLORS_SEQUENCE[this->_cursor_position]);
+      if(--this->_cursor_run == 0)
+      {
+        this->_cursor_run = PIXELS_CHASE_WIDTH;
+        if(++this->_cursor_position >= FLASH_COLORS_SEQUENCE_LENGTH)
+        {
+          this->_cursor_position = 0;
+        }
+      }
+      return color;
+    case LedStripRgbMode::FADE:
+      color = LedStripRGB::wheel(this->_cursor_position);
+      this->_cursor_position += this->_cursor_step;
+      if(this->_cursor_position >= FADE_POSITIONS)
+      {
+        this->_cursor_position -= FADE_POSITIONS;
+      }
+      return color;
+    default:
+      return this->_cursor_color;
+  }
+}
+
+/**
+ * It allows to turn on the LEDs of the strip, with the ramp of setRampTime().
+ */
+void LedStripPixels::turnOn(void)
+{
+  this->_state = true;
+  this->_brightness.setTarget(255);
+}
+
+/**
+ * It allows to turn off the LEDs of the strip. With a ramp time the frames
+ * keep running while the brightness goes down.
+ */
+void LedStripPixels::turnOff(void)
+{
+  if(this->_state)
+  {
+    this->_state = false;
+    this->_brightness.setTarget(0);
+    if(this->_brightness.getValue() == 0)
+    {
+      this->sendBlack();
+    }
+  }
+}
+
+/**
+ * It allows to obtain the current status of the LEDs of the strip
+ * @return  The current state
+ */
+LedStripState LedStripPixels::getState(void)
+{
+  return this->_state ? LedStripState::ON : LedStripState::OFF;
+}
+
+/**
+ * Sets the speed of the spatial Flash and Fade, on the speed curve of
+ * LedStripRGB from a step per frame (0) to a step every 10 s (1024).
+ * @param speed Speed value (0 - 1024), as provided by the potentiometer
+ */
+void LedStripPixels::setSpeed(uint16_t speed)
+{
+  this->_speed = constrain(speed, 0, SPEED_CURVE_MAX);
+  this->_step_rate = speedToStepRate(speedFrom(this->_speed, SPEED_CURVE_20MS));
+}
+
+uint16_t LedStripPixels::getSpeed(void)
+{
+  return this->_speed;
+}
+
+/**
+ * Allows to make turning on and off gradual. By default the changes are
+ * immediate (0).
+ * @param time Milliseconds of a ramp over the full scale
+ */
+void LedStripPixels::setRampTime(uint16_t time)
+{
+  this->_brightness.setTime(time);
+}
+
+/**
+ * Adds a segment after the last one.
+ * @param length Number of pixels of the segment
+ * @param mode Mode of the segment
+ * @param color Color of the segment in hexadecimal format
+ * @return The index of the segment, 0xFF if there is no room for it
+ */
+uint8_t LedStripPixels::addSegment(uint16_t length, LedStripRgbMode mode, uint32_t color)
+{
+  if(this->_segments_count >= PIXELS_MAX_SEGMENTS || length == 0)
+  {
+    return 0xFF;
+  }
+  PixelSegment &segment = this->_segments[this->_segments_count];
+  segment.length = length;
+  segment.mode = mode;
+  segment.color = color;
+  segment.effect = nullptr;
+  segment.context = nullptr;
+  return this->_segments_count++;
+}
+
+/**
+ * It allows to change the mode of a segment.
+ */
+void LedStripPixels::setSegmentMode(uint8_t index, LedStripRgbMode mode)
+{
+  if(index < this->_segments_count)
+  {
+    this->_segments[index].mode = mode;
+  }
+}
+
+/**
+ * It allows to change the color of a segment.
+ */
+void LedStripPixels::setSegmentColor(uint8_t index, uint32_t color)
+{
+  if(index < this->_segments_count)
+  {
+    this->_segments[index].color = color;
+  }
+}
+
+/**
+ * It allows to show a pixel effect in a segment, nullptr goes back to the mode
+ * of the segment.
+ * @param index Index of the segment
+ * @param effect Function that computes the pixels
+ * @param context Parameters passed to the effect
+ */
+void LedStripPixels::setSegmentEffect(uint8_t index, PixelEffect effect, void *context)
+{
+  if(index < this->_segments_count)
+  {
+    this->_segments[index].effect = effect;
+    this->_segments[index].context = context;
+  }
+}
+
+/**
+ * It allows to obtain the number of pixels of all the segments.
+ */
+uint16_t LedStripPixels::getLength(void)
+{
+  uint16_t length = 0;
+  for(uint8_t i = 0; i < this->_segments_count; i++)
+  {
+    length += this->_segments[i].length;
+  }
+  return length;
+}
+
+/**
+ * Sends a frame buffer to the strip.
+ * @param pixels Colors of the pixels
+ * @param count Number of pixels
+ */
+void LedStripPixels::write(const RGBColor *pixels, uint16_t count)
+{
+  for(uint16_t i = 0; i < count; i++)
+  {
+    this->sendPixel(((uint32_t)pixels[i].red << 16) |
+      ((uint32_t)pixels[i].green << 8) | pixels[i].blue);
+  }
+}
+
+/**
+ * Computes and sends a frame, segment by segment, with the brightness of the
+ * ramp. The throughput of the frame is measured, see getPixelsPerSecond() and
+ * getPixelCycles().
+ */
+void LedStripPixels::show(void)
+{
+  uint32_t start = micros();
+  uint16_t count = 0;
+  uint8_t brightness = this->_brightness.getValue();
+  for(uint8_t s = 0; s < this->_segments_count; s++)
+  {
+    const PixelSegment &segment = this->_segments[s];
+    this->beginSegment(segment);
+    for(uint16_t i = 0; i < segment.length; i++)
+    {
+      uint32_t color = this->nextPixel(segment);
+      if(brightness < 255)
+      {
+        color = scaleColor(color, brightness);
+      }
+      this->sendPixel(color);
+    }
+    count += segment.length;
+  }
+  uint32_t elapsed = micros() - start;
+  if(elapsed > 0 && count > 0)
+  {
+    this->_pixels_per_second = (uint32_t)count * 1000000UL / elapsed;
+    this->_pixel_cycles = elapsed * (F_CPU / 1000000UL) / count;
+  }
+}
+
+/**
+ * Sends a new frame every PIXELS_FRAME_DELAY milliseconds while the LEDs are
+ * turned on or ramping down. The frames keep their cadence, a late frame
+ * does not delay the next ones, and the phase of the effects advances by
+ * the time of a frame.
+ */
+void LedStripPixels::loop(void)
+{
+  if(!this->_state && this->_brightness.getValue() == 0)
+  {
+    return;
+  }
+  if((millis() - this->_last_frame_time) < PIXELS_FRAME_DELAY)
+  {
+    return;
+  }
+  this->_last_frame_time += PIXELS_FRAME_DELAY;
+  if((millis() - this->_last_frame_time) >= PIXELS_FRAME_DELAY)
+  {
+    this->_last_frame_time = millis();
+  }
+  this->_frame++;
+  this->_phase += PIXELS_FRAME_DELAY * this->_step_rate;
+  uint32_t cycle = (uint32_t)PIXELS_PHASE_STEPS << SPEED_CURVE_PHASE_BITS;
+  if(this->_phase >= cycle)
+  {
+    this->_phase %= cycle;
+  }
+  this->_brightness.step(PIXELS_FRAME_DELAY);
+  if(!this->_state && this->_brightness.getValue() == 0)
+  {
+    this->sendBlack();
+    return;
+  }
+  this->show();
+}
+
+/**
+ * It allows to obtain the throughput of the last frame in pixels per second,
+ * including the time to compute the pixels.
+ */
+uint32_t LedStripPixels::getPixelsPerSecond(void)
+{
+  return this->_pixels_per_second;
+}
+
+/**
+ * It allows to obtain the CPU cycles spent per pixel in the last frame. The
+ * transmission of the 24 bits takes 480 cycles at 16 MHz (240 at 8 MHz), the
+ * rest is the computation of the pixel and the gap between pixels.
+ */
+uint16_t LedStripPixels::getPixelCycles(void)
+{
+  return this->_pixel_cycles;
+}
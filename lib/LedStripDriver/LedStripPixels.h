@@ -0,0 +1,105 @@
+/*
+ * LedStripPixels.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "LedStrip.h"
+#include "LedStripRGB.h"
+#include "LedRamp.h"
+#include "PixelEffects.h"
+
+#ifndef LED_STRIP_PIXELS_H_
+#define LED_STRIP_PIXELS_H_
+
+#define PIXELS_MAX_SEGMENTS 4
+#define PIXELS_FRAME_DELAY 20
+#define PIXELS_CHASE_WIDTH 4
+// Steps of a whole cycle of the phase: a chase of the Flash colors, also four
+// turns of the Fade wheel
+#define PIXELS_PHASE_STEPS (PIXELS_CHASE_WIDTH * FLASH_COLORS_SEQUENCE_LENGTH)
+
+/**
+ * A run of consecutive pixels that shows the same mode, or the same pixel
+ * effect when it is set.
+ */
+struct PixelSegment
+{
+  uint16_t length;
+  LedStripRgbMode mode;
+  uint32_t color;
+  PixelEffect effect;
+  void *context;
+};
+
+/**
+ * LedStripPixels allows to handle an addressable led strip (WS2812 and
+ * compatibles) connected to a pin of the port B.
+ * The pixels of each segment are computed while the frame is sent, so no frame
+ * buffer is needed. The modes of LedStripRGB have a spatial version:
+ *  - NORMAL: all the pixels with the color of the segment.
+ *  - STROBE: the even and the odd pixels alternate the color of the segment.
+ *  - FLASH: blocks of the Flash sequence colors chasing along the segment, a
+ *    pixel every step.
+ *  - FADE: a gradient of the Fade sequence moving along the segment, a color
+ *    of the wheel every step.
+ * The steps follow the speed curve of LedStripRGB (see setSpeed()) and
+ * turning on and off follows a brightness ramp, like the analog strips.
+ * A segment can also show a pixel effect (see PixelEffects.h) instead of a
+ * mode.
+ */
+class LedStripPixels
+{
+  private:
+    uint8_t _pin;
+    uint8_t _pin_mask;
+    bool _state = false;
+
+    PixelSegment _segments[PIXELS_MAX_SEGMENTS];
+    uint8_t _segments_count = 0;
+
+    uint16_t _frame = 0;
+    uint32_t _last_frame_time = 0;
+    uint16_t _speed;
+    uint32_t _step_rate;
+    uint32_t _phase = 0;
+    LedRamp _brightness;
+    uint32_t _pixels_per_second = 0;
+    uint16_t _pixel_cycles = 0;
+
+    uint32_t _cursor_color;
+    uint16_t _cursor_position;
+    uint16_t _cursor_step;
+    uint8_t _cursor_run;
+    uint16_t _cursor_index;
+
+    void beginSegment(const PixelSegment&);
+    uint32_t nextPixel(const PixelSegment&);
+    void sendPixel(uint32_t);
+    void sendBlack(void);
+
+  public:
+    LedStripPixels(uint8_t pin);
+    void setup(void);
+    void turnOn(void);
+    void turnOff(void);
+    LedStripState getState(void);
+    void setSpeed(uint16_t);
+    uint16_t getSpeed(void);
+    void setRampTime(uint16_t);
+    uint8_t addSegment(uint16_t, LedStripRgbMode, uint32_t);
+    void setSegmentMode(uint8_t, LedStripRgbMode);
+    void setSegmentColor(uint8_t, uint32_t);
+    void setSegmentEffect(uint8_t, PixelEffect, void*);
+    uint16_t getLength(void);
+    void write(const RGBColor*, uint16_t);
+    void show(void);
+    void loop(void);
+    uint32_t getPixelsPerSecond(void);
+    uint16_t getPixelCycles(void);
+};
+
+#endif /* LED_STRIP_PIXELS_H_ */
@@ -6,11 +6,24 @@
  * http://creativecommons.org/licenses/by/4.0/
  */
 #include "LedStripRGB.h"
+#include "ColorMath.h"
 #include <Arduino.h>
 
 LedStripRGB::LedStripRGB(RGBColor pins)
+  : LedStripRGB(pins, pin_output)
 {
-  this->_pins = pins;
+}
+
+/**
+ * Constructor of the class for a strip on logical channels of an output.
+ * @param channels Channels of the output for red, green and blue
+ * @param output Output that drives the channels
+ */
+LedStripRGB::LedStripRGB(RGBColor channels, LedOutput &output)
+{
+  this->_channels = channels;
+  this->_output = &output;
+  this->setSpeed(DEFAULT_SPEED);
 }
 
 RGBColor LedStripRGB::hex2rgb(uint32_t hex)
@@ -25,141 +38,287 @@ RGBColor LedStripRGB::hex2rgb(uint32_t hex)
 
 void LedStripRGB::showColor(uint32_t color)
 {
-  RGBColor rgb = this->hex2rgb(color);
-  if(this->_common_anode)
-  {
-    analogWrite(this->_pins.red, 255 - rgb.red);
-    analogWrite(this->_pins.green, 255 - rgb.green);
-    analogWrite(this->_pins.blue, 255 - rgb.blue);
-  }
-  else
-  {
-    analogWrite(this->_pins.red, rgb.red);
-    analogWrite(this->_pins.green, rgb.green);
-    analogWrite(this->_pins.blue, rgb.blue);
-  }
-}
-
-void LedStripRGB::strobe(void)
-{
-  if((millis() - this->_last_sequence_time) > STROBE_DELAY)
+  if(this->_blend_duration > 0)
   {
-    this->_last_sequence_time = millis();
-    if(this->_strobe_state == true)
+    uint32_t elapsed = millis() - this->_blend_start;
+    if(elapsed >= this->_blend_duration)
     {
-      this->showColor(this->_color);
-      this->_strobe_state = false;
+      this->_blend_duration = 0;
     }
     else
     {
-      this->showColor(COLOR_BLACK);
-      this->_strobe_state = true;
+      color = blendColor(this->_blend_from, color,
+        (elapsed << 8) / this->_blend_duration);
     }
   }
+  this->_base_color = color;
+  this->_output_color = this->composite(color);
+  this->writeColor(this->_output_color);
 }
 
-void LedStripRGB::flash(void)
+/**
+ * Advances the phase of the overlay layers.
+ * @param elapsed Milliseconds since the previous frame
+ */
+void LedStripRGB::stepOverlays(uint16_t elapsed)
 {
-  uint16_t delay = FLASH_DELAY + (600 * (this->_speed / 1024));
-  if((millis() - this->_last_sequence_time) > delay)
+  for(uint8_t i = 0; i < RGB_OVERLAYS; i++)
   {
-    this->_last_sequence_time = millis();
-    if(this->_flash_counter >= FLASH_COLORS_SEQUENCE_LENGTH)
+    if(this->_overlays[i].mode != LedOverlayMode::OVERLAY_NONE)
     {
-      this->_flash_counter = 0;
+      this->_overlays[i].phase += this->_overlays[i].rate * elapsed;
     }
-    this->showColor(FLASH_COLORS_SEQUENCE[this->_flash_counter++]);
   }
 }
 
-void LedStripRGB::fade(void)
+/**
+ * Applies the overlay layers in order on the color of the base layer.
+ *  - MODULATE: scales the color with a triangle wave, depth is the dip.
+ *  - FLASH: adds the color of the overlay, starting at depth and decaying
+ *    to nothing over the period.
+ *  - GATE: passes the color during the first depth / 256 of the period and
+ *    black for the rest.
+ * @param color Color of the base layer
+ */
+uint32_t LedStripRGB::composite(uint32_t color)
 {
-  uint16_t delay = FADE_DELAY + (200 * (this->_speed / 1024));
-  if((millis() - this->_last_sequence_time) > delay)
+  for(uint8_t i = 0; i < RGB_OVERLAYS; i++)
   {
-    this->_last_sequence_time = millis();
-    if(this->_fade_counter >= 6)
-    {
-      this->_fade_counter = 0;
-    }
-    switch (this->_fade_counter) {
-      case 0:
-        if (this->_fade_iteration < 256)
-        {
-          analogWrite(this->_pins.red, this->_fade_iteration++);
-        }
-        else
-        {
-          this->_fade_counter++;
-        }
+    LedOverlay &overlay = this->_overlays[i];
+    uint8_t phase = overlay.phase >> 8;
+    switch (overlay.mode) {
+      case LedOverlayMode::OVERLAY_MODULATE:
+      {
+        uint8_t wave = phase < 128 ? phase << 1 : (255 - phase) << 1;
+        color = scaleColor(color, 255 - scale8(overlay.depth, 255 - wave));
         break;
-      case 1:
-        if (this->_fade_iteration > 0)
-        {
-          analogWrite(this->_pins.blue, this->_fade_iteration--);
-        }
-        else
-        {
-          this->_fade_counter++;
-        }
+      }
+      case LedOverlayMode::OVERLAY_FLASH:
+        color = addColor(color,
+          scaleColor(overlay.color, scale8(overlay.depth, 255 - phase)));
         break;
-      case 2:
-        if(this->_fade_iteration < 256)
+      case LedOverlayMode::OVERLAY_GATE:
+        if(phase > overlay.depth)
         {
-          analogWrite(this->_pins.green, this->_fade_iteration++);
-        }
-        else
-        {
-          this->_fade_counter++;
-        }
-        break;
-      case 3:
-        if(this->_fade_iteration > 0)
-        {
-          analogWrite(this->_pins.red, this->_fade_iteration--);
-        }
-        else
-        {
-          this->_fade_counter++;
-        }
-        break;
-      case 4:
-        if(this->_fade_iteration < 256)
-        {
-          analogWrite(this->_pins.blue, this->_fade_iteration++);
-        }
-        else
-        {
-          this->_fade_counter++;
-        }
-        break;
-      case 5:
-        if(this->_fade_iteration > 0)
-        {
-          analogWrite(this->_pins.green, this->_fade_iteration--);
-        }
-        else
-        {
-          this->_fade_counter++;
+          color = COLOR_BLACK;
         }
         break;
       default:
-        this->_fade_counter = 0;
-        this->_fade_iteration = 0;
+        break;
     }
   }
+  return color;
+}
+
+/**
+ * Writes a color to the pins, applying the brightness and the output scale.
+ */
+void LedStripRGB::writeColor(uint32_t color)
+{
+  uint8_t brightness = this->_brightness.getValue();
+  if(this->_output_scale < 255)
+  {
+    brightness = scale8(brightness, this->_output_scale);
+  }
+  if(brightness < 255)
+  {
+    color = scaleColor(color, brightness);
+  }
+  this->_idle = false;
+  RGBColor rgb = this->hex2rgb(color);
+  if(this->_common_anode)
+  {
+    this->_output->write(this->_channels.red, 255 - rgb.red);
+    this->_output->write(this->_channels.green, 255 - rgb.green);
+    this->_output->write(this->_channels.blue, 255 - rgb.blue);
+  }
+  else
+  {
+    this->_output->write(this->_channels.red, rgb.red);
+    this->_output->write(this->_channels.green, rgb.green);
+    this->_output->write(this->_channels.blue, rgb.blue);
+  }
+  this->_output->commit();
+}
+
+/**
+ * Alternates the color and black every STROBE_DELAY milliseconds. The times
+ * of the changes are scheduled from the previous change instead of from the
+ * frame that detected it, so the period does not drift with the frame rate.
+ * The color is shown in every frame, so ramps and blends stay smooth.
+ */
+void LedStripRGB::strobe(void)
+{
+  uint32_t now = millis();
+  if((now - this->_last_sequence_time) >= STROBE_DELAY)
+  {
+    this->_last_sequence_time += STROBE_DELAY;
+    if((now - this->_last_sequence_time) >= STROBE_DELAY)
+    {
+      this->_last_sequence_time = now;
+    }
+    this->_strobe_state = !this->_strobe_state;
+  }
+  this->showColor(this->_strobe_state ? COLOR_BLACK : this->_color);
+}
+
+/**
+ * Advances the phase of the current effect by the time elapsed since the last
+ * call, at the rate given by the speed curve. The phase wraps after the given
+ * number of whole steps.
+ * @param steps Number of steps of the effect cycle
+ */
+void LedStripRGB::advancePhase(uint8_t steps)
+{
+  uint32_t now = millis();
+  uint32_t elapsed = now - this->_last_sequence_time;
+  this->_last_sequence_time = now;
+  if(elapsed > 1000)
+  {
+    elapsed = 1000;
+  }
+  this->_phase += elapsed * this->_step_rate;
+  uint32_t cycle = (uint32_t)steps << SPEED_CURVE_PHASE_BITS;
+  if(this->_phase >= cycle)
+  {
+    this->_phase %= cycle;
+  }
+}
+
+void LedStripRGB::flash(void)
+{
+  this->advancePhase(FLASH_COLORS_SEQUENCE_LENGTH);
+  uint8_t index = this->_phase >> SPEED_CURVE_PHASE_BITS;
+  this->showColor(pgm_read_dword(&FLASH_COLORS_SEQUENCE[index]));
+}
+
+void LedStripRGB::fade(void)
+{
+  this->advancePhase(FADE_STEPS);
+  this->showColor(wheel(this->_phase >> (SPEED_CURVE_PHASE_BITS - 8)));
+}
+
+/**
+ * Color of the Fade sequence at the given position. The sequence has six
+ * segments of 256 levels, in each one a single channel goes up or down.
+ * @param position Position in the sequence (0 - 1535)
+ * @return Color in hexadecimal format
+ */
+uint32_t LedStripRGB::wheel(uint16_t position)
+{
+  uint8_t up = position & 0xFF;
+  uint8_t down = 255 - up;
+  switch (position >> 8) {
+    case 0:
+      return ((uint32_t)up << 16) | 0x0000FF;
+    case 1:
+      return 0xFF0000 | down;
+    case 2:
+      return 0xFF0000 | ((uint32_t)up << 8);
+    case 3:
+      return ((uint32_t)down << 16) | 0x00FF00;
+    case 4:
+      return 0x00FF00 | up;
+    default:
+      return ((uint32_t)down << 8) | 0x0000FF;
+  }
+}
+
+void LedStripRGB::music(void)
+{
+  if(this->_audio == nullptr)
+  {
+    this->showColor(this->_color);
+  }
+  else if(this->_audio->beatDetected())
+  {
+    this->showColor(COLOR_WHITE);
+  }
+  else
+  {
+    RGBColor levels = this->_audio->getLevels();
+    this->showColor(((uint32_t)levels.red << 16) |
+      ((uint32_t)levels.green << 8) | levels.blue);
+  }
+}
+
+/**
+ * Starts the audio analyzer while the LEDs are on in Music mode and stops it
+ * otherwise, so the analog input is free for analogRead().
+ */
+void LedStripRGB::updateAudio(void)
+{
+  if(this->_audio == nullptr)
+  {
+    return;
+  }
+  if(this->_state && this->_mode == LedStripRgbMode::MUSIC)
+  {
+    this->_audio->begin();
+  }
+  else
+  {
+    this->_audio->end();
+  }
+}
+
+/**
+ * Scales the color with the level of the flicker noise. Fire does not use
+ * the color, it goes from a deep red at low levels to orange at full level.
+ * @param style Character of the noise
+ * @param elapsed Milliseconds since the previous frame
+ */
+void LedStripRGB::flicker(FlickerStyle style, uint16_t elapsed)
+{
+  this->_flicker.step(style, elapsed);
+  uint8_t level = this->_flicker.getLevel();
+  if(style == FlickerStyle::FLICKER_FIRE)
+  {
+    this->showColor(((uint32_t)level << 16) | ((uint16_t)(scale8(level, level) >> 1) << 8));
+  }
+  else
+  {
+    this->showColor(scaleColor(this->_color, level));
+  }
 }
 
 void LedStripRGB::setup(void)
 {
-  pinMode(this->_pins.red, OUTPUT);
-  pinMode(this->_pins.green, OUTPUT);
-  pinMode(this->_pins.blue, OUTPUT);
+  this->_output->setup(this->_channels.red);
+  this->_output->setup(this->_channels.green);
+  this->_output->setup(this->_channels.blue);
+  this->writeIdle();
 }
 
 void LedStripRGB::setCommonAnodeEnable(bool enabled)
 {
-  this->_common_anode = enabled;
+  if(enabled != this->_common_anode)
+  {
+    this->_common_anode = enabled;
+    if(this->_idle)
+    {
+      this->writeIdle();
+    }
+    else
+    {
+      this->writeColor(this->_output_color);
+    }
+  }
+}
+
+/**
+ * Leaves the pins at their idle level (LEDs off).
+ */
+void LedStripRGB::writeIdle(void)
+{
+  uint8_t idle = this->_common_anode ? 255 : 0;
+  this->_output->write(this->_channels.red, idle);
+  this->_output->write(this->_channels.green, idle);
+  this->_output->write(this->_channels.blue, idle);
+  this->_output->commit();
+  this->_output_color = COLOR_BLACK;
+  this->_base_color = COLOR_BLACK;
+  this->_idle = true;
 }
 
 void LedStripRGB::turnOn(void)
@@ -167,32 +326,39 @@ void LedStripRGB::turnOn(void)
   if(this->_state == false)
   {
     this->_state = true;
+    this->_brightness.setTarget(255);
+    this->updateAudio();
   }
 }
 
+/**
+ * Turns off the LEDs. With a ramp time the output keeps running while the
+ * brightness goes down, then the pins are left at their idle level.
+ */
 void LedStripRGB::turnOff(void)
 {
   if(this->_state)
   {
-    if (this->_common_anode)
-    {
-      digitalWrite(this->_pins.red, HIGH);
-      digitalWrite(this->_pins.green, HIGH);
-      digitalWrite(this->_pins.blue, HIGH);
-    }
-    else
+    this->_state = false;
+    this->_brightness.setTarget(0);
+    if(this->_brightness.getValue() == 0)
     {
-      digitalWrite(this->_pins.red, LOW);
-      digitalWrite(this->_pins.green, LOW);
-      digitalWrite(this->_pins.blue, LOW);
+      this->writeIdle();
     }
-    this->_state = false;
+    this->updateAudio();
   }
 }
 
 LedStripState LedStripRGB::toggle(void)
 {
-  this->_state = !this->_state;
+  if(this->_state)
+  {
+    this->turnOff();
+  }
+  else
+  {
+    this->turnOn();
+  }
   return this->_state ? LedStripState::ON : LedStripState::OFF;
 }
 
@@ -230,7 +396,12 @@ RGBColor LedStripRGB::getRGBColor(void)
 
 void LedStripRGB::setMode(LedStripRgbMode mode)
 {
+  if(mode != this->_mode)
+  {
+    this->crossFade(this->_transition_time);
+  }
   this->_mode = mode;
+  this->updateAudio();
 }
 
 LedStripRgbMode LedStripRGB::getMode(void)
@@ -240,6 +411,7 @@ LedStripRgbMode LedStripRGB::getMode(void)
 
 LedStripRgbMode LedStripRGB::nextMode(void)
 {
+  this->crossFade(this->_transition_time);
   switch (this->_mode) {
     case LedStripRgbMode::NORMAL:
       this->_mode = LedStripRgbMode::STROBE;
@@ -251,32 +423,251 @@ LedStripRgbMode LedStripRGB::nextMode(void)
       this->_mode = LedStripRgbMode::FADE;
       break;
     case LedStripRgbMode::FADE:
-      this->_mode = LedStripRgbMode::NORMAL;
+      this->_mode = LedStripRgbMode::CANDLE;
+      break;
+    case LedStripRgbMode::CANDLE:
+      this->_mode = LedStripRgbMode::FIRE;
+      break;
+    case LedStripRgbMode::FIRE:
+      this->_mode = LedStripRgbMode::TWINKLE;
+      break;
+    case LedStripRgbMode::TWINKLE:
+      this->_mode = this->_audio != nullptr ?
+        LedStripRgbMode::MUSIC : LedStripRgbMode::NORMAL;
       break;
     default:
       this->_mode = LedStripRgbMode::NORMAL;
   }
   this->_strobe_state = false;
-  this->_flash_counter = 0;
-  this->_fade_counter = 0;
-  this->_fade_iteration = 0;
+  this->_phase = 0;
+  this->updateAudio();
   return this->_mode;
 }
 
+/**
+ * It allows to know if the current mode is the last one of the sequence of
+ * modes, Music when an audio analyzer is available, Twinkle otherwise.
+ */
+bool LedStripRGB::isLastMode(void)
+{
+  if(this->_audio != nullptr)
+  {
+    return this->_mode == LedStripRgbMode::MUSIC;
+  }
+  return this->_mode == LedStripRgbMode::TWINKLE;
+}
+
+/**
+ * It allows to know if the mode exists in this build, Music needs an audio
+ * analyzer.
+ * @param mode Value of a LedStripRgbMode, for example read from the EEPROM
+ */
+bool LedStripRGB::hasMode(uint8_t mode)
+{
+  if(mode == LedStripRgbMode::MUSIC)
+  {
+    return this->_audio != nullptr;
+  }
+  return mode <= LedStripRgbMode::TWINKLE;
+}
+
+/**
+ * Allows to add the Music mode to the sequence of modes. The colors of the
+ * mode are the levels of the bass, mid and high bands of the analyzer, and the
+ * detected beats are shown as white flashes.
+ * @param audio Analyzer of the audio input
+ */
+void LedStripRGB::setAudioAnalyzer(AudioAnalyzer *audio)
+{
+  this->_audio = audio;
+  this->updateAudio();
+}
+
 uint16_t LedStripRGB::getSpeed(void)
 {
   return this->_speed;
 }
 
+/**
+ * Sets the speed of the Flash and Fade sequences, the period of a step goes
+ * from 10 s (1024) down to one frame (BOARD_FRAME_DELAY, speed 0) on the
+ * speed curve. The limit only catches the rounding of the curve.
+ * @param speed Speed value (0 - 1024), as provided by the potentiometer
+ */
 void LedStripRGB::setSpeed(uint16_t speed)
 {
-  this->_speed = constrain(speed, 0, 1024);
+  this->_speed = constrain(speed, 0, SPEED_CURVE_MAX);
+  this->_step_rate = speedToStepRate(speedFrom(this->_speed, EFFECT_MIN_SPEED));
+  if(this->_step_rate > EFFECT_MAX_STEP_RATE)
+  {
+    this->_step_rate = EFFECT_MAX_STEP_RATE;
+  }
+}
+
+/**
+ * Blends the color shown now with the output of the following frames for the
+ * given time, so the changes of color, mode or speed are smooth. The color
+ * shown now is held, the blend is linear on each channel and the brightness
+ * in between is not kept.
+ * @param duration Duration of the blend in milliseconds
+ */
+void LedStripRGB::crossFade(uint16_t duration)
+{
+  this->_blend_from = this->_state ? this->_base_color : COLOR_BLACK;
+  this->_blend_start = millis();
+  this->_blend_duration = duration;
+}
+
+/**
+ * Allows to blend the last frame of a mode into the frames of the next one
+ * when the mode changes. By default the changes are immediate (0).
+ * @param time Milliseconds of the blend
+ */
+void LedStripRGB::setTransitionTime(uint16_t time)
+{
+  this->_transition_time = time;
+}
+
+/**
+ * Puts an effect on top of the current mode, for example a breathing of a
+ * fixed color or a strobe over a slow fade. The layers are applied in order
+ * once per frame in 8 bits.
+ * @param layer Index of the layer (0 - RGB_OVERLAYS - 1)
+ * @param mode Operation of the layer, OVERLAY_NONE to remove it
+ * @param period Milliseconds of a cycle of the effect, 0 to hold it still
+ * @param depth Amount of the effect (0 - 255)
+ * @param color Color added by FLASH
+ */
+void LedStripRGB::setOverlay(uint8_t layer, LedOverlayMode mode,
+  uint16_t period, uint8_t depth, uint32_t color)
+{
+  if(layer >= RGB_OVERLAYS)
+  {
+    return;
+  }
+  LedOverlay &overlay = this->_overlays[layer];
+  overlay.mode = mode;
+  overlay.depth = depth;
+  overlay.rate = period > 1 ? 0x10000UL / period : 0;
+  overlay.phase = 0;
+  overlay.color = color;
+}
+
+/**
+ * Removes all the overlay layers, only the mode is shown.
+ */
+void LedStripRGB::clearOverlays(void)
+{
+  for(uint8_t i = 0; i < RGB_OVERLAYS; i++)
+  {
+    this->_overlays[i].mode = LedOverlayMode::OVERLAY_NONE;
+  }
+}
+
+/**
+ * It allows to obtain the state of the strip, including the phase of the
+ * effect and the point of the brightness ramp, so it can be restored after a
+ * reset. The overlays are not included.
+ */
+LedStripRGBSnapshot LedStripRGB::getSnapshot(void)
+{
+  LedStripRGBSnapshot snapshot;
+  snapshot.color = this->_color;
+  snapshot.phase = this->_phase;
+  snapshot.speed = this->_speed;
+  snapshot.mode = this->_mode;
+  snapshot.brightness = this->_brightness.getValue();
+  snapshot.on = this->_state;
+  snapshot.strobe_state = this->_strobe_state;
+  return snapshot;
+}
+
+/**
+ * Restores the state of getSnapshot() and shows it at once, without the
+ * blend of a mode change. The effect continues from the same phase.
+ */
+void LedStripRGB::restoreSnapshot(const LedStripRGBSnapshot &snapshot)
+{
+  this->_color = snapshot.color;
+  this->setSpeed(snapshot.speed);
+  this->_mode = snapshot.mode <= LedStripRgbMode::TWINKLE ?
+    static_cast<LedStripRgbMode>(snapshot.mode) : LedStripRgbMode::NORMAL;
+  this->_phase = snapshot.phase;
+  this->_strobe_state = snapshot.strobe_state;
+  this->_state = snapshot.on;
+  this->_brightness.jumpTo(snapshot.brightness);
+  this->_brightness.setTarget(snapshot.on ? 255 : 0);
+  this->_blend_duration = 0;
+  this->_last_sequence_time = millis();
+  this->_last_update = this->_last_sequence_time;
+  this->updateAudio();
+  this->loop();
+}
+
+/**
+ * Allows to make turning on and off gradual, the brightness of the output
+ * follows a ramp of the given time. By default the changes are immediate (0).
+ * @param time Milliseconds of a ramp over the full scale
+ */
+void LedStripRGB::setRampTime(uint16_t time)
+{
+  this->_brightness.setTime(time);
+}
+
+/**
+ * Allows to choose the shape of the ramps (LINEAR or SMOOTH).
+ */
+void LedStripRGB::setRampEase(LedRampEase ease)
+{
+  this->_brightness.setEase(ease);
+}
+
+/**
+ * Allows to limit the output without changing the colors of the modes, for
+ * example to keep the current of the strip within the budget of the supply.
+ * @param scale Fraction of the output (0 - 255), 255 for no limit
+ */
+void LedStripRGB::setOutputScale(uint8_t scale)
+{
+  if(scale != this->_output_scale)
+  {
+    this->_output_scale = scale;
+    if(!this->_idle)
+    {
+      this->writeColor(this->_output_color);
+    }
+  }
+}
+
+/**
+ * It allows to obtain the color requested by the current mode and brightness,
+ * before the output scale is applied. It is black when the LEDs are off.
+ */
+RGBColor LedStripRGB::getOutputColor(void)
+{
+  if(this->_idle)
+  {
+    return this->hex2rgb(COLOR_BLACK);
+  }
+  return this->hex2rgb(scaleColor(this->_output_color, this->_brightness.getValue()));
 }
 
 void LedStripRGB::loop(void)
 {
-  if(this->_state)
+  uint32_t now = millis();
+  uint16_t elapsed = now - this->_last_update > 0xFFFF ? 0xFFFF : now - this->_last_update;
+  this->_last_update = now;
+  this->_brightness.step(elapsed);
+  if(!this->_state && this->_brightness.getValue() == 0)
+  {
+    if(!this->_idle)
+    {
+      this->writeIdle();
+    }
+  }
+  else
   {
+    this->stepOverlays(elapsed);
     switch (this->_mode) {
       case LedStripRgbMode::NORMAL:
         this->showColor(this->_color);
@@ -290,6 +681,18 @@ void LedStripRGB::loop(void)
       case LedStripRgbMode::FADE:
         this->fade();
         break;
+      case LedStripRgbMode::MUSIC:
+        this->music();
+        break;
+      case LedStripRgbMode::CANDLE:
+        this->flicker(FlickerStyle::FLICKER_CANDLE, elapsed);
+        break;
+      case LedStripRgbMode::FIRE:
+        this->flicker(FlickerStyle::FLICKER_FIRE, elapsed);
+        break;
+      case LedStripRgbMode::TWINKLE:
+        this->flicker(FlickerStyle::FLICKER_TWINKLE, elapsed);
+        break;
       default:
         this->showColor(this->_color);
     }
@@ -8,7 +8,13 @@
 
 #include <inttypes.h>
 #include "LedStrip.h"
+#include "LedRamp.h"
+#include "LedOutput.h"
+#include "BoardProfile.h"
 #include "RGBColors.h"
+#include "SpeedCurve.h"
+#include "AudioAnalyzer.h"
+#include "Flicker.h"
 
 #ifndef LED_STRIP_RGB_H_
 #define LED_STRIP_RGB_H_
@@ -18,39 +24,124 @@ enum LedStripRgbMode
   NORMAL,
   STROBE,
   FLASH,
-  FADE
+  FADE,
+  MUSIC,
+  CANDLE,
+  FIRE,
+  TWINKLE
 };
 
-#define STROBE_DELAY 200
-#define FLASH_DELAY 400
-#define FADE_DELAY 5
+/**
+ * Operation of an overlay layer on the output of the mode (base layer).
+ */
+enum LedOverlayMode
+{
+  OVERLAY_NONE,
+  OVERLAY_MODULATE,
+  OVERLAY_FLASH,
+  OVERLAY_GATE
+};
+
+/**
+ * State of an overlay layer, the phase advances a full period every
+ * 65536 / rate milliseconds.
+ */
+struct LedOverlay
+{
+  LedOverlayMode mode;
+  uint8_t depth;
+  uint16_t rate;
+  uint16_t phase;
+  uint32_t color;
+};
+
+#define RGB_OVERLAYS 2
+
+/**
+ * State of a LedStripRGB kept across a reset (14 bytes): the mode and the
+ * point of its effect, the color, the speed and the brightness.
+ */
+struct LedStripRGBSnapshot
+{
+  uint32_t color;
+  uint32_t phase;
+  uint16_t speed;
+  uint8_t mode;
+  uint8_t brightness;
+  bool on;
+  bool strobe_state;
+};
+
+#if defined(__AVR__)
+static_assert(sizeof(LedStripRGBSnapshot) == 14, "LedStripRGBSnapshot is not 14 bytes");
+#endif
+
+#define STROBE_DELAY BOARD_STROBE_DELAY
+#define DEFAULT_SPEED 512
+// Highest phase increment per millisecond of the effects: one step per frame,
+// a faster Flash or Fade would skip steps between frames and alias
+#define EFFECT_MAX_STEP_RATE (SPEED_CURVE_PHASE_ONE / BOARD_FRAME_DELAY)
+// Speed of the curve with a step per frame, the speed 0 of the effects
+#if BOARD_FRAME_DELAY == 10
+#define EFFECT_MIN_SPEED SPEED_CURVE_10MS
+#elif BOARD_FRAME_DELAY == 20
+#define EFFECT_MIN_SPEED SPEED_CURVE_20MS
+#else
+#error "No speed of the curve for this BOARD_FRAME_DELAY, add it to SpeedCurve.h"
+#endif
+#define FADE_STEPS 6
+#define FADE_POSITIONS (FADE_STEPS * 256)
 
 class LedStripRGB
 {
   private:
-    RGBColor _pins;
-    bool _state;
-    uint32_t _color;
+    RGBColor _channels;
+    LedOutput *_output;
+    bool _state = false;
+    uint32_t _color = COLOR_BLACK;
     uint16_t _speed;
+    uint32_t _step_rate;
 
     LedStripRgbMode _mode = LedStripRgbMode::NORMAL;
     uint32_t _last_sequence_time = 0;
     bool _strobe_state = false;
-    uint32_t _flash_counter = 0;
-    uint32_t _fade_counter = 0;
-    uint32_t _fade_iteration = 0;
+    uint32_t _phase = 0;
+
+    uint32_t _output_color = COLOR_BLACK;
+    uint32_t _base_color = COLOR_BLACK;
+    LedOverlay _overlays[RGB_OVERLAYS] = {};
+    uint32_t _blend_from = COLOR_BLACK;
+    uint32_t _blend_start = 0;
+    uint16_t _blend_duration = 0;
+    uint16_t _transition_time = 0;
+
+    LedRamp _brightness;
+    uint8_t _output_scale = 255;
+    uint32_t _last_update = 0;
+    bool _idle = true;
 
     bool _common_anode = false;
+    AudioAnalyzer *_audio = nullptr;
+    Flicker _flicker;
 
     RGBColor hex2rgb(uint32_t);
     void showColor(uint32_t);
+    void writeColor(uint32_t);
+    void writeIdle(void);
+    void advancePhase(uint8_t);
+    void stepOverlays(uint16_t);
+    uint32_t composite(uint32_t);
 
     void strobe(void);
     void flash(void);
     void fade(void);
+    void music(void);
+    void flicker(FlickerStyle, uint16_t);
+    void updateAudio(void);
 
   public:
     LedStripRGB(RGBColor pins);
+    LedStripRGB(RGBColor channels, LedOutput &output);
     void setup(void);
     void setCommonAnodeEnable(bool);
     void turnOn(void);
@@ -64,8 +155,22 @@ class LedStripRGB
     void setMode(LedStripRgbMode);
     LedStripRgbMode getMode(void);
     LedStripRgbMode nextMode(void);
+    bool isLastMode(void);
+    bool hasMode(uint8_t);
+    void setAudioAnalyzer(AudioAnalyzer*);
+    static uint32_t wheel(uint16_t);
     void setSpeed(uint16_t);
     uint16_t getSpeed(void);
+    void crossFade(uint16_t);
+    void setTransitionTime(uint16_t);
+    void setOverlay(uint8_t, LedOverlayMode, uint16_t, uint8_t, uint32_t = COLOR_WHITE);
+    void clearOverlays(void);
+    LedStripRGBSnapshot getSnapshot(void);
+    void restoreSnapshot(const LedStripRGBSnapshot&);
+    void setRampTime(uint16_t);
+    void setRampEase(LedRampEase);
+    void setOutputScale(uint8_t);
+    RGBColor getOutputColor(void);
     void loop(void);
 };
 
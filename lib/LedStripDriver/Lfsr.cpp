@@ -0,0 +1,41 @@
+/*
+ * Lfsr.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "Lfsr.h"
+
+/**
+ * Constructor of the class.
+ * @param seed Initial state, zero is replaced because it would lock the LFSR
+ */
+Lfsr::Lfsr(uint16_t seed)
+{
+  this->seed(seed);
+}
+
+/**
+ * Restarts the sequence from the given state.
+ * @param seed Initial state, zero is replaced because it would lock the LFSR
+ */
+void Lfsr::seed(uint16_t seed)
+{
+  this->_state = seed != 0 ? seed : 0xACE1;
+}
+
+/**
+ * Advances the register one step.
+ * @return The new state
+ */
+uint16_t Lfsr::next(void)
+{
+  uint16_t lsb = this->_state & 1;
+  this->_state >>= 1;
+  if(lsb)
+  {
+    this->_state ^= LFSR_TAPS;
+  }
+  return this->_state;
+}
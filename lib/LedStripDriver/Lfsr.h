@@ -0,0 +1,32 @@
+/*
+ * Lfsr.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef LFSR_H_
+#define LFSR_H_
+
+// Taps of the maximal length 16 bits Galois LFSR (x^16 + x^14 + x^13 + x^11 + 1)
+#define LFSR_TAPS 0xB400
+
+/**
+ * Lfsr is a 16 bits Galois linear feedback shift register, a cheap source of
+ * pseudo random numbers that repeats every 65535 values.
+ */
+class Lfsr
+{
+  private:
+    uint16_t _state;
+
+  public:
+    Lfsr(uint16_t seed = 0xACE1);
+    void seed(uint16_t);
+    uint16_t next(void);
+};
+
+#endif /* LFSR_H_ */
@@ -0,0 +1,102 @@
+/*
+ * LightSchedule.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "LightSchedule.h"
+#include "ColorMath.h"
+#include <Arduino.h>
+
+/**
+ * Constructor of the class.
+ * @param rgb RGB LEDs driven by the schedule
+ * @param white White LEDs driven by the schedule
+ * @param table Points of the schedule in PROGMEM, sorted by minute
+ * @param length Number of points
+ */
+LightSchedule::LightSchedule(LedStripRGB &rgb, LedStrip &white,
+  const ScheduleEntry *table, uint8_t length) : _rgb(rgb), _white(white)
+{
+  this->_table = table;
+  this->_length = length;
+}
+
+void LightSchedule::readEntry(uint8_t index, ScheduleEntry &entry)
+{
+  memcpy_P(&entry, &this->_table[index], sizeof(ScheduleEntry));
+}
+
+void LightSchedule::enable(void)
+{
+  this->_enabled = true;
+}
+
+void LightSchedule::disable(void)
+{
+  this->_enabled = false;
+}
+
+bool LightSchedule::isEnabled(void)
+{
+  return this->_enabled;
+}
+
+/**
+ * Sets the LEDs for the given time of the day, if the schedule is enabled.
+ * @param minute Minutes since midnight (0 - 1439)
+ */
+void LightSchedule::apply(uint16_t minute)
+{
+  if(!this->_enabled || this->_length == 0)
+  {
+    return;
+  }
+  // Last point at or before the minute, the last one of the day before the
+  // first point.
+  uint8_t index = this->_length - 1;
+  ScheduleEntry from;
+  for(uint8_t i = 0; i < this->_length; i++)
+  {
+    readEntry(i, from);
+    if(from.minute > minute)
+    {
+      break;
+    }
+    index = i;
+  }
+  ScheduleEntry to;
+  readEntry(index, from);
+  readEntry(index + 1 < this->_length ? index + 1 : 0, to);
+
+  uint16_t span = (to.minute + MINUTES_PER_DAY - from.minute) % MINUTES_PER_DAY;
+  uint16_t elapsed = (minute + MINUTES_PER_DAY - from.minute) % MINUTES_PER_DAY;
+  uint8_t amount = span > 0 ? ((uint32_t)elapsed << 8) / span : 0;
+
+  uint8_t white = scale8(from.white, 255 - amount) + scale8(to.white, amount);
+  uint32_t color = blendColor(
+    ((uint32_t)from.color[0] << 16) | ((uint16_t)from.color[1] << 8) | from.color[2],
+    ((uint32_t)to.color[0] << 16) | ((uint16_t)to.color[1] << 8) | to.color[2],
+    amount);
+
+  if(white == 0)
+  {
+    this->_white.turnOff();
+  }
+  else
+  {
+    this->_white.setIntensity(white);
+    this->_white.turnOn();
+  }
+  if(color == COLOR_BLACK)
+  {
+    this->_rgb.turnOff();
+  }
+  else
+  {
+    this->_rgb.setMode(static_cast<LedStripRgbMode>(from.mode));
+    this->_rgb.setColor(color);
+    this->_rgb.turnOn();
+  }
+}
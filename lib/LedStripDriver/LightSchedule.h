@@ -0,0 +1,58 @@
+/*
+ * LightSchedule.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "LedStrip.h"
+#include "LedStripRGB.h"
+
+#ifndef LIGHT_SCHEDULE_H_
+#define LIGHT_SCHEDULE_H_
+
+#ifndef MINUTES_PER_DAY
+#define MINUTES_PER_DAY 1440
+#endif
+
+/**
+ * A point of the schedule (7 bytes). Between two points the white intensity
+ * and the color are interpolated, the mode is the one of the earlier point.
+ * A black color turns off the RGB LEDs and a white intensity of 0 turns off
+ * the white LEDs.
+ */
+struct ScheduleEntry
+{
+  uint16_t minute;
+  uint8_t white;
+  uint8_t color[3];
+  uint8_t mode;
+};
+
+/**
+ * LightSchedule drives the LEDs from a table of points of the day stored in
+ * the flash memory (PROGMEM), sorted by minute. The table wraps around
+ * midnight.
+ */
+class LightSchedule
+{
+  private:
+    LedStripRGB &_rgb;
+    LedStrip &_white;
+    const ScheduleEntry *_table;
+    uint8_t _length;
+    bool _enabled = false;
+
+    void readEntry(uint8_t, ScheduleEntry&);
+
+  public:
+    LightSchedule(LedStripRGB &rgb, LedStrip &white, const ScheduleEntry *table, uint8_t length);
+    void enable(void);
+    void disable(void);
+    bool isEnabled(void);
+    void apply(uint16_t);
+};
+
+#endif /* LIGHT_SCHEDULE_H_ */
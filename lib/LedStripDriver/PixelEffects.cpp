@@ -0,0 +1,77 @@
+/*
+ * PixelEffects.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "PixelEffects.h"
+#include "ColorMath.h"
+#include "LedStripRGB.h"
+#include <Arduino.h>
+
+/**
+ * Triangle wave of 8 bits, it goes up from 0 to 254 and down again.
+ */
+static uint8_t triangle8(uint8_t value)
+{
+  return value < 128 ? value << 1 : (255 - value) << 1;
+}
+
+/**
+ * Rainbow: the Fade sequence spread along the segment, a hue step of 2^scale
+ * per pixel, moving one step every 2^speed frames.
+ */
+uint32_t pixelRainbow(void *context, uint16_t index, uint16_t frame)
+{
+  PixelEffectContext *effect = static_cast<PixelEffectContext*>(context);
+  uint8_t hue = (index << effect->scale) + (frame >> effect->speed);
+  return LedStripRGB::wheel((uint16_t)hue * 6);
+}
+
+/**
+ * Chase: blocks of 2^scale pixels with the colors of the palette, moving one
+ * pixel every 2^speed frames.
+ */
+uint32_t pixelChase(void *context, uint16_t index, uint16_t frame)
+{
+  PixelEffectContext *effect = static_cast<PixelEffectContext*>(context);
+  uint16_t position = (uint16_t)(index - (frame >> effect->speed)) >> effect->scale;
+  return pgm_read_dword(&effect->palette[position % effect->palette_length]);
+}
+
+/**
+ * Twinkle: one of every 2^scale pixels (in average) lights up with a color of
+ * the palette, then fades out. A new set of pixels is chosen every 2^speed
+ * frames. The pixels are chosen by an LFSR seeded with the number of the set,
+ * so the set is the same during all its frames. The speed must be at least 1.
+ */
+uint32_t pixelTwinkle(void *context, uint16_t index, uint16_t frame)
+{
+  PixelEffectContext *effect = static_cast<PixelEffectContext*>(context);
+  if(index == 0)
+  {
+    effect->lfsr.seed((frame >> effect->speed) ^ 0x5A5A);
+  }
+  uint16_t random = effect->lfsr.next();
+  if((random & ((1 << effect->scale) - 1)) != 0)
+  {
+    return COLOR_BLACK;
+  }
+  uint32_t color = pgm_read_dword(&effect->palette[(random >> 8) % effect->palette_length]);
+  uint8_t phase = frame << (8 - effect->speed);
+  return scaleColor(color, triangle8(phase));
+}
+
+/**
+ * Gradient: the first two colors of the palette blended back and forth along
+ * the segment, with a period of 256 / 2^scale pixels, moving one step every
+ * 2^speed frames.
+ */
+uint32_t pixelGradient(void *context, uint16_t index, uint16_t frame)
+{
+  PixelEffectContext *effect = static_cast<PixelEffectContext*>(context);
+  uint8_t position = (index << effect->scale) + (frame >> effect->speed);
+  return blendColor(pgm_read_dword(&effect->palette[0]), pgm_read_dword(&effect->palette[1]),
+    triangle8(position));
+}
@@ -0,0 +1,46 @@
+/*
+ * PixelEffects.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "RGBColors.h"
+#include "Lfsr.h"
+
+#ifndef PIXEL_EFFECTS_H_
+#define PIXEL_EFFECTS_H_
+
+/**
+ * A pixel effect computes the color of a pixel from its index in the segment
+ * and the number of frame: color = f(index, frame). It is evaluated while the
+ * frame is sent, so it must be short. The pixels of a segment are always
+ * evaluated in order, starting with index 0.
+ */
+typedef uint32_t (*PixelEffect)(void *context, uint16_t index, uint16_t frame);
+
+/**
+ * Parameters of the effects of this file.
+ *  - palette: colors used by the Chase, Twinkle and Gradient effects, in the
+ *    flash memory (PROGMEM).
+ *  - scale: spatial size as a power of two (pixels per color, hue step,
+ *    1 / density of the twinkles).
+ *  - speed: frames per step as a power of two (0 - 8).
+ */
+struct PixelEffectContext
+{
+  const uint32_t *palette = FLASH_COLORS_SEQUENCE;
+  uint8_t palette_length = FLASH_COLORS_SEQUENCE_LENGTH;
+  uint8_t scale = 2;
+  uint8_t speed = 1;
+  Lfsr lfsr;
+};
+
+uint32_t pixelRainbow(void*, uint16_t, uint16_t);
+uint32_t pixelChase(void*, uint16_t, uint16_t);
+uint32_t pixelTwinkle(void*, uint16_t, uint16_t);
+uint32_t pixelGradient(void*, uint16_t, uint16_t);
+
+#endif /* PIXEL_EFFECTS_H_ */
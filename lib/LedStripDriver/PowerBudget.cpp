@@ -0,0 +1,83 @@
+/*
+ * PowerBudget.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "PowerBudget.h"
+
+/**
+ * Constructor of the class.
+ * @param budget Maximum current of the strip in mA
+ */
+PowerBudget::PowerBudget(uint16_t budget)
+{
+  this->_budget = budget;
+}
+
+void PowerBudget::setBudget(uint16_t budget)
+{
+  this->_budget = budget;
+}
+
+/**
+ * Allows to set the current of a channel at full duty.
+ * @param channel Channel of the strip
+ * @param current Current in mA per meter of strip
+ * @param length Length of the strip in decimeters
+ */
+void PowerBudget::setChannel(PowerChannel channel, uint16_t current, uint8_t length)
+{
+  uint32_t full = (uint32_t)current * length / 10;
+  this->_full_current[channel] = full > 0xFFFF ? 0xFFFF : full;
+}
+
+/**
+ * Estimates the current for the duties of the channels and computes the scale
+ * that keeps it within the budget.
+ * @param white Duty of the white channel
+ * @param rgb Duty of the RGB channels
+ * @return Scale for all the channels, 255 when no limit is needed
+ */
+uint8_t PowerBudget::update(uint8_t white, RGBColor rgb)
+{
+  uint32_t current = (uint32_t)white * this->_full_current[POWER_WHITE] +
+    (uint32_t)rgb.red * this->_full_current[POWER_RED] +
+    (uint32_t)rgb.green * this->_full_current[POWER_GREEN] +
+    (uint32_t)rgb.blue * this->_full_current[POWER_BLUE];
+  current >>= 8;
+  this->_current = current > 0xFFFF ? 0xFFFF : current;
+  if(current <= this->_budget)
+  {
+    this->_scale = 255;
+    return this->_scale;
+  }
+  // Largest scale with (current * (scale + 1)) >> 8 within the budget, found
+  // bit by bit from the most significant one.
+  uint8_t scale = 0;
+  for(uint8_t bit = 0x80; bit != 0; bit >>= 1)
+  {
+    uint8_t candidate = scale | bit;
+    if(((current * (candidate + 1)) >> 8) <= this->_budget)
+    {
+      scale = candidate;
+    }
+  }
+  this->_scale = scale;
+  return scale;
+}
+
+/**
+ * It allows to obtain the estimated current of the last update, in mA and
+ * before the scale is applied.
+ */
+uint16_t PowerBudget::getCurrent(void)
+{
+  return this->_current;
+}
+
+uint8_t PowerBudget::getScale(void)
+{
+  return this->_scale;
+}
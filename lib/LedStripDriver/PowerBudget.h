@@ -0,0 +1,49 @@
+/*
+ * PowerBudget.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "RGBColors.h"
+
+#ifndef POWER_BUDGET_H_
+#define POWER_BUDGET_H_
+
+/**
+ * Channels of the strip, in the order of the duties given to update().
+ */
+enum PowerChannel
+{
+  POWER_WHITE,
+  POWER_RED,
+  POWER_GREEN,
+  POWER_BLUE
+};
+
+/**
+ * PowerBudget estimates the current drawn by the strip from the duty of the
+ * four channels and, when it is over the budget of the supply, computes the
+ * scale (0 - 255) that must be applied to all the channels to stay within it.
+ * The estimation and the scale only use multiplications and shifts.
+ */
+class PowerBudget
+{
+  private:
+    uint16_t _budget;
+    uint16_t _full_current[4] = { 0, 0, 0, 0 };
+    uint16_t _current = 0;
+    uint8_t _scale = 255;
+
+  public:
+    PowerBudget(uint16_t budget);
+    void setBudget(uint16_t);
+    void setChannel(PowerChannel, uint16_t, uint8_t);
+    uint8_t update(uint8_t, RGBColor);
+    uint16_t getCurrent(void);
+    uint8_t getScale(void);
+};
+
+#endif /* POWER_BUDGET_H_ */
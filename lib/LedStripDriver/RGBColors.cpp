@@ -0,0 +1,23 @@
+/*
+ * RGBColors.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "RGBColors.h"
+#include <Arduino.h>
+
+// A single copy in the flash memory, as a const array of the header it took
+// 24 bytes of SRAM in each file that used it
+const uint32_t FLASH_COLORS_SEQUENCE[] PROGMEM = {
+  COLOR_RED,
+  COLOR_GREEN,
+  COLOR_BLUE,
+  COLOR_YELLOW,
+  COLOR_VIOLET,
+  COLOR_SCARLET
+};
+
+static_assert(array_length(FLASH_COLORS_SEQUENCE) == FLASH_COLORS_SEQUENCE_LENGTH,
+  "FLASH_COLORS_SEQUENCE_LENGTH does not match the colors");
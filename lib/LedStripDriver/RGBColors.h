@@ -229,15 +229,8 @@ const uint32_t ALL_COLORS[] = {
 
 const uint32_t ALL_COLORS_LENGTH = array_length(ALL_COLORS);
 
-const uint32_t FLASH_COLORS_SEQUENCE[] = {
-  COLOR_RED,
-  COLOR_GREEN,
-  COLOR_BLUE,
-  COLOR_YELLOW,
-  COLOR_VIOLET,
-  COLOR_SCARLET
-};
-
-const uint32_t FLASH_COLORS_SEQUENCE_LENGTH = array_length(FLASH_COLORS_SEQUENCE);
+// Colors of the Flash mode, in the flash memory (read with pgm_read_dword)
+extern const uint32_t FLASH_COLORS_SEQUENCE[];
+const uint8_t FLASH_COLORS_SEQUENCE_LENGTH = 6;
 
 #endif /* RGB_COLORS_H_ */
\ No newline at end of file
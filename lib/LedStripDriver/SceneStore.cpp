@@ -0,0 +1,199 @@
+/*
+ * SceneStore.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "SceneStore.h"
+#include <Arduino.h>
+#include <avr/eeprom.h>
+
+// Size of the header: mask of the stored slots and last saved slot
+#define SCENE_HEADER_SIZE 3
+
+/**
+ * Constructor of the class.
+ * @param rgb RGB LEDs handled by the scenes
+ * @param white White LEDs handled by the scenes
+ * @param address First EEPROM address used by the store
+ */
+SceneStore::SceneStore(LedStripRGB &rgb, LedStrip &white, uint16_t address) :
+  _rgb(rgb), _white(white)
+{
+  this->_address = address;
+}
+
+/**
+ * Allows to save the color and mode of the RGB LEDs that the color
+ * temperature mode gives back, instead of its tint.
+ * @param cct Color temperature mode that mixes the LEDs of the scenes
+ */
+void SceneStore::setCctWhite(CctWhite *cct)
+{
+  this->_cct = cct;
+}
+
+/**
+ * Pointer of the EEPROM functions to an offset of the store.
+ */
+void *SceneStore::eepromAddress(uint16_t offset)
+{
+  return (void*)(uintptr_t)(this->_address + offset);
+}
+
+void *SceneStore::slotAddress(uint8_t slot)
+{
+  return this->eepromAddress(SCENE_HEADER_SIZE + slot * sizeof(Scene));
+}
+
+void SceneStore::writeHeader(void)
+{
+  eeprom_update_word((uint16_t*)this->eepromAddress(0), this->_stored);
+  eeprom_update_byte((uint8_t*)this->eepromAddress(2), this->_last_saved);
+}
+
+/**
+ * Reads the header of the store. An erased EEPROM has no stored scenes.
+ */
+void SceneStore::setup(void)
+{
+  this->_stored = eeprom_read_word((const uint16_t*)this->eepromAddress(0));
+  this->_last_saved = eeprom_read_byte((const uint8_t*)this->eepromAddress(2));
+  if(this->_stored == 0xFFFF && this->_last_saved == 0xFF)
+  {
+    this->_stored = 0;
+  }
+  if(this->_last_saved >= SCENES_COUNT)
+  {
+    this->_last_saved = SCENES_COUNT - 1;
+  }
+  this->_current = this->_last_saved;
+}
+
+/**
+ * It allows to know if there is a scene stored in the slot.
+ */
+bool SceneStore::isStored(uint8_t slot)
+{
+  return slot < SCENES_COUNT && (this->_stored & (1 << slot));
+}
+
+/**
+ * Stores the current state of the LEDs in the slot.
+ * @param slot Slot of the scene (0 - SCENES_COUNT - 1)
+ */
+void SceneStore::save(uint8_t slot)
+{
+  if(slot >= SCENES_COUNT)
+  {
+    return;
+  }
+  // The color temperature mode only borrows the RGB LEDs, the scene keeps
+  // the color and the mode that it gives back
+  uint32_t color = this->_cct != nullptr ? this->_cct->getRgbColor() : this->_rgb.getColor();
+  LedStripRgbMode mode = this->_cct != nullptr ? this->_cct->getRgbMode() : this->_rgb.getMode();
+  uint16_t speed = this->_rgb.getSpeed() >> 2;
+  Scene scene;
+  scene.mode = mode & SCENE_MODE_MASK;
+  if(this->_rgb.getState() == LedStripState::ON)
+  {
+    scene.mode |= SCENE_RGB_ON;
+  }
+  if(this->_white.getState() == LedStripState::ON)
+  {
+    scene.mode |= SCENE_WHITE_ON;
+  }
+  scene.color[0] = color >> 16;
+  scene.color[1] = color >> 8;
+  scene.color[2] = color;
+  scene.speed = speed > 255 ? 255 : speed;
+  scene.white = this->_white.getIntensity();
+  eeprom_update_block(&scene, this->slotAddress(slot), sizeof(Scene));
+  this->_stored |= 1 << slot;
+  this->_last_saved = slot;
+  this->_current = slot;
+  this->writeHeader();
+}
+
+/**
+ * Stores the current state of the LEDs in the slot after the last saved one,
+ * the oldest scenes are replaced when all the slots are used.
+ * @return The slot of the scene
+ */
+uint8_t SceneStore::saveNext(void)
+{
+  uint8_t slot = this->_last_saved + 1;
+  if(slot >= SCENES_COUNT)
+  {
+    slot = 0;
+  }
+  this->save(slot);
+  return slot;
+}
+
+/**
+ * Removes the scene of the slot.
+ */
+void SceneStore::clear(uint8_t slot)
+{
+  if(this->isStored(slot))
+  {
+    this->_stored &= ~(1 << slot);
+    this->writeHeader();
+  }
+}
+
+/**
+ * Restores the scene of the slot, with a cross fade of the RGB LEDs. A mode
+ * that this build does not have (a corrupt or older EEPROM, or Music without
+ * an audio analyzer) is shown as NORMAL.
+ * @param slot Slot of the scene
+ * @return false if there is no scene stored in the slot
+ */
+bool SceneStore::recall(uint8_t slot)
+{
+  if(!this->isStored(slot))
+  {
+    return false;
+  }
+  Scene scene;
+  eeprom_read_block(&scene, this->slotAddress(slot), sizeof(Scene));
+  this->_current = slot;
+
+  uint8_t mode = scene.mode & SCENE_MODE_MASK;
+  this->_rgb.setMode(this->_rgb.hasMode(mode) ?
+    static_cast<LedStripRgbMode>(mode) : LedStripRgbMode::NORMAL);
+  this->_rgb.setColor(((uint32_t)scene.color[0] << 16) |
+    ((uint32_t)scene.color[1] << 8) | scene.color[2]);
+  this->_rgb.setSpeed((uint16_t)scene.speed << 2);
+  // After setMode, which starts the shorter blend of a mode change, and
+  // before the state, the blend starts from what is shown now
+  this->_rgb.crossFade(SCENE_FADE_DURATION);
+  this->_rgb.setState(scene.mode & SCENE_RGB_ON ? LedStripState::ON : LedStripState::OFF);
+
+  this->_white.setIntensity(scene.white);
+  this->_white.setState(scene.mode & SCENE_WHITE_ON ? LedStripState::ON : LedStripState::OFF);
+  return true;
+}
+
+/**
+ * Restores the next stored scene after the last recalled or saved one.
+ * @return The slot of the scene, 0xFF if there are no stored scenes
+ */
+uint8_t SceneStore::recallNext(void)
+{
+  uint8_t slot = this->_current;
+  for(uint8_t i = 0; i < SCENES_COUNT; i++)
+  {
+    if(++slot >= SCENES_COUNT)
+    {
+      slot = 0;
+    }
+    if(this->recall(slot))
+    {
+      return slot;
+    }
+  }
+  return 0xFF;
+}
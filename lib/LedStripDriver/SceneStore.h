@@ -0,0 +1,71 @@
+/*
+ * SceneStore.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "LedStrip.h"
+#include "LedStripRGB.h"
+#include "CctWhite.h"
+
+#ifndef SCENE_STORE_H_
+#define SCENE_STORE_H_
+
+#define SCENES_COUNT 16
+#define SCENE_FADE_DURATION 500
+
+// Flags stored with the mode of a scene
+#define SCENE_MODE_MASK 0x0F
+#define SCENE_RGB_ON 0x10
+#define SCENE_WHITE_ON 0x20
+
+/**
+ * A scene as stored in the EEPROM (6 bytes).
+ */
+struct Scene
+{
+  uint8_t mode;
+  uint8_t color[3];
+  uint8_t speed;
+  uint8_t white;
+};
+
+/**
+ * SceneStore keeps up to SCENES_COUNT scenes (state, mode, color and speed of
+ * the RGB LEDs and state and intensity of the white LEDs) in the EEPROM.
+ * The EEPROM starts with a header (mask of the stored slots and the last saved
+ * slot) that is the only data read on setup, so recalling a scene is a single
+ * read of its slot. While the color temperature mode is on, the scene keeps
+ * the color and mode of the RGB LEDs that it gives back.
+ */
+class SceneStore
+{
+  private:
+    LedStripRGB &_rgb;
+    LedStrip &_white;
+    uint16_t _address;
+    uint16_t _stored = 0;
+    uint8_t _last_saved = SCENES_COUNT - 1;
+    uint8_t _current = SCENES_COUNT - 1;
+    CctWhite *_cct = nullptr;
+
+    void *eepromAddress(uint16_t);
+    void *slotAddress(uint8_t);
+    void writeHeader(void);
+
+  public:
+    SceneStore(LedStripRGB &rgb, LedStrip &white, uint16_t address = 0);
+    void setCctWhite(CctWhite*);
+    void setup(void);
+    bool isStored(uint8_t);
+    void save(uint8_t);
+    uint8_t saveNext(void);
+    void clear(uint8_t);
+    bool recall(uint8_t);
+    uint8_t recallNext(void);
+};
+
+#endif /* SCENE_STORE_H_ */
@@ -0,0 +1,259 @@
+/*
+ * SoftPwm.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "SoftPwm.h"
+#include <Arduino.h>
+#include "BoardProfile.h"
+
+// Timer1 and its interruptions belong to the engine selected by the profile
+// (LED_OUTPUT_BACKEND), the other engine is built without them so both can
+// be linked in the same program
+#if defined(__AVR__) && LED_OUTPUT_BACKEND == LED_OUTPUT_SOFT_PWM
+#define SOFT_PWM_TIMER1
+#endif
+
+#if defined(__AVR_ATtiny85__)
+// Normal mode, the overflow starts the period and OCR1A schedules the edges
+#define SOFT_PWM_PERIOD_vect TIMER1_OVF_vect
+#define SOFT_PWM_EDGE_vect TIMER1_COMPA_vect
+#define SOFT_PWM_OCR OCR1A
+#else
+// CTC mode with TOP = OCR1A = 255, OCR1B schedules the edges
+#define SOFT_PWM_PERIOD_vect TIMER1_COMPA_vect
+#define SOFT_PWM_EDGE_vect TIMER1_COMPB_vect
+#define SOFT_PWM_OCR OCR1B
+#endif
+
+// Engine that receives the Timer1 interruptions
+static SoftPwm *soft_pwm_instance = nullptr;
+
+/**
+ * Constructor of the class.
+ * @param port Output register of the port of the channels (&PORTB)
+ * @param ddr Direction register of the same port (&DDRB)
+ */
+SoftPwm::SoftPwm(volatile uint8_t *port, volatile uint8_t *ddr)
+{
+  this->_port = port;
+  this->_ddr = ddr;
+  for(uint8_t channel = 0; channel < SOFT_PWM_CHANNELS; channel++)
+  {
+    this->_duty[channel] = 0;
+  }
+}
+
+/**
+ * Configures Timer1 and starts the generation of the channels.
+ */
+void SoftPwm::begin(void)
+{
+  soft_pwm_instance = this;
+#if defined(SOFT_PWM_TIMER1)
+  uint8_t sreg = SREG;
+  cli();
+#if defined(__AVR_ATtiny85__)
+  GTCCR &= ~(_BV(PWM1B) | _BV(COM1B1) | _BV(COM1B0));
+  TCCR1 = _BV(CS13) | _BV(CS10);
+  TCNT1 = 0;
+  TIFR = _BV(OCF1A) | _BV(TOV1);
+  TIMSK |= _BV(OCIE1A) | _BV(TOIE1);
+#else
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS12);
+  OCR1A = 255;
+  TCNT1 = 0;
+  TIFR1 = _BV(OCF1A) | _BV(OCF1B);
+  TIMSK1 = _BV(OCIE1A) | _BV(OCIE1B);
+#endif
+  SREG = sreg;
+#endif
+}
+
+/**
+ * Stops Timer1 and leaves all the channels low.
+ */
+void SoftPwm::end(void)
+{
+#if defined(SOFT_PWM_TIMER1)
+  uint8_t sreg = SREG;
+  cli();
+#if defined(__AVR_ATtiny85__)
+  TIMSK &= ~(_BV(OCIE1A) | _BV(TOIE1));
+  TCCR1 = 0;
+#else
+  TIMSK1 = 0;
+  TCCR1B = 0;
+#endif
+  *this->_port &= ~this->_channels;
+  SREG = sreg;
+#endif
+}
+
+/**
+ * Set the bit of the channel as an output, starting low.
+ * @param channel Bit of the port (0 - 7)
+ */
+void SoftPwm::setup(uint8_t channel)
+{
+  if(channel >= SOFT_PWM_CHANNELS)
+  {
+    return;
+  }
+  uint8_t bit = 1 << channel;
+  noInterrupts();
+  *this->_port &= ~bit;
+  *this->_ddr |= bit;
+  interrupts();
+  this->_channels |= bit;
+  this->schedule();
+}
+
+/**
+ * Changes the duty of a channel, it is applied from the next period.
+ * @param channel Bit of the port (0 - 7)
+ * @param duty Duty of the channel (0 - 255)
+ */
+void SoftPwm::write(uint8_t channel, uint8_t duty)
+{
+  if(channel >= SOFT_PWM_CHANNELS || this->_duty[channel] == duty)
+  {
+    return;
+  }
+  this->_duty[channel] = duty;
+  this->schedule();
+}
+
+/**
+ * Sorts the channels by duty into the schedule that is not in use. The
+ * channels with the same duty share an edge, 0 is never turned on and 255 is
+ * never turned off.
+ */
+void SoftPwm::schedule(void)
+{
+  // While there is no swap pending the interruption keeps its buffer
+  this->_pending = false;
+  uint8_t buffer = this->_active ^ 1;
+  uint8_t *times = this->_times[buffer];
+  uint8_t *masks = this->_masks[buffer];
+  uint8_t count = 0;
+  uint8_t on = 0;
+  for(uint8_t channel = 0; channel < SOFT_PWM_CHANNELS; channel++)
+  {
+    uint8_t bit = 1 << channel;
+    uint8_t duty = this->_duty[channel];
+    if(!(this->_channels & bit) || duty == 0)
+    {
+      continue;
+    }
+    on |= bit;
+    if(duty == 255)
+    {
+      continue;
+    }
+    uint8_t i = 0;
+    while(i < count && times[i] < duty)
+    {
+      i++;
+    }
+    if(i < count && times[i] == duty)
+    {
+      masks[i] |= bit;
+      continue;
+    }
+    for(uint8_t j = count; j > i; j--)
+    {
+      times[j] = times[j - 1];
+      masks[j] = masks[j - 1];
+    }
+    times[i] = duty;
+    masks[i] = bit;
+    count++;
+  }
+  this->_on[buffer] = on;
+  this->_count[buffer] = count;
+  // The schedule must be complete in memory before it is handed over
+  __asm__ __volatile__("" ::: "memory");
+  this->_pending = true;
+}
+
+/**
+ * It allows to know the number of edge interruptions per period of the
+ * current schedule, the cost of the engine grows with it.
+ */
+uint8_t SoftPwm::getEdges(void)
+{
+  return this->_count[this->_pending ? this->_active ^ 1 : this->_active];
+}
+
+/**
+ * Called by the timer at the start of each period. Swaps in the new schedule
+ * if any, turns on the channels and schedules the first edge.
+ */
+void SoftPwm::periodStart(void)
+{
+  if(this->_pending)
+  {
+    this->_active ^= 1;
+    this->_pending = false;
+  }
+  uint8_t buffer = this->_active;
+  *this->_port = (*this->_port & ~this->_channels) | this->_on[buffer];
+  this->_edge = 0;
+#if defined(__AVR__)
+  if(this->_count[buffer] > 0)
+  {
+    SOFT_PWM_OCR = this->_times[buffer][0];
+  }
+#endif
+}
+
+/**
+ * Called by the timer at each edge. Turns off the channels that end there
+ * and schedules the next edge, the edges that are too close to be scheduled
+ * are applied in the same interruption.
+ */
+void SoftPwm::edge(void)
+{
+  uint8_t buffer = this->_active;
+  uint8_t count = this->_count[buffer];
+  uint8_t edge = this->_edge;
+  if(edge >= count)
+  {
+    return;
+  }
+  uint8_t off = this->_masks[buffer][edge++];
+#if defined(__AVR__)
+  while(edge < count && this->_times[buffer][edge] <= TCNT1 + 1)
+  {
+    off |= this->_masks[buffer][edge++];
+  }
+  if(edge < count)
+  {
+    SOFT_PWM_OCR = this->_times[buffer][edge];
+  }
+#endif
+  *this->_port &= ~off;
+  this->_edge = edge;
+}
+
+#if defined(SOFT_PWM_TIMER1)
+ISR(SOFT_PWM_PERIOD_vect)
+{
+  if(soft_pwm_instance != nullptr)
+  {
+    soft_pwm_instance->periodStart();
+  }
+}
+
+ISR(SOFT_PWM_EDGE_vect)
+{
+  if(soft_pwm_instance != nullptr)
+  {
+    soft_pwm_instance->edge();
+  }
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+ * SoftPwm.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "LedOutput.h"
+
+#ifndef SOFT_PWM_H_
+#define SOFT_PWM_H_
+
+// One channel for each bit of the port
+#define SOFT_PWM_CHANNELS 8
+
+/**
+ * SoftPwm generates an 8 bits PWM on any bit of a port with Timer1, so every
+ * channel gets the full resolution even on pins without hardware PWM (blue on
+ * P3 of the Digispark) and several zones can share one engine.
+ * The channels are the bits of the port (on the Digispark channel n is Pn).
+ * At the start of each period all the channels with duty are turned on, then
+ * one compare interrupt is scheduled for each distinct duty, sorted from the
+ * shortest to the longest, and turns off the channels that end there. The
+ * cost is at most N + 1 interrupts per period for N channels, the schedule is
+ * sorted in write() and swapped in at the start of the next period.
+ * The period is 256 ticks of F_CPU / 256, ~252 Hz at 16.5 MHz.
+ * It takes over Timer1, the hardware PWM of P4 is lost and the core must keep
+ * millis() on Timer0.
+ */
+class SoftPwm : public LedOutput
+{
+  private:
+    volatile uint8_t *_port;
+    volatile uint8_t *_ddr;
+    uint8_t _channels = 0;
+    uint8_t _duty[SOFT_PWM_CHANNELS];
+
+    // Double buffered schedule, _active is used by the interruption
+    uint8_t _on[2] = { 0, 0 };
+    uint8_t _count[2] = { 0, 0 };
+    uint8_t _times[2][SOFT_PWM_CHANNELS];
+    uint8_t _masks[2][SOFT_PWM_CHANNELS];
+    volatile uint8_t _active = 0;
+    volatile bool _pending = false;
+    uint8_t _edge = 0;
+
+    void schedule(void);
+
+  public:
+    SoftPwm(volatile uint8_t *port, volatile uint8_t *ddr);
+    void begin(void);
+    void end(void);
+    void setup(uint8_t channel);
+    void write(uint8_t channel, uint8_t duty);
+    uint8_t getEdges(void);
+    void periodStart(void);
+    void edge(void);
+};
+
+#endif /* SOFT_PWM_H_ */
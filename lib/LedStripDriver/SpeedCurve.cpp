@@ -0,0 +1,58 @@
+/*
+ * SpeedCurve.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "SpeedCurve.h"
+#include <Arduino.h>
+
+/**
+ * Phase increment per millisecond for 33 points of the speed range. The period
+ * of an effect step goes from 1 ms (speed 0) to 10 s (speed 1024), a decade
+ * every 8 points of the table (256 speed units): rate = 2^20 / 10^(i / 8).
+ */
+const uint32_t SPEED_CURVE_STEP_RATE[] PROGMEM = {
+  1048576, 786321, 589658, 442181, 331589, 248657, 186466, 139830,
+  104858, 78632, 58966, 44218, 33159, 24866, 18647, 13983,
+  10486, 7863, 5897, 4422, 3316, 2487, 1865, 1398,
+  1049, 786, 590, 442, 332, 249, 186, 140,
+  105
+};
+
+/**
+ * Converts a speed value (0 - 1024) into the phase increment per millisecond.
+ * The value is interpolated between the two nearest points of the curve.
+ * @param speed Speed value, as provided by the potentiometer
+ * @return Phase increment per millisecond
+ */
+uint32_t speedToStepRate(uint16_t speed)
+{
+  if(speed >= SPEED_CURVE_MAX)
+  {
+    return pgm_read_dword(&SPEED_CURVE_STEP_RATE[SPEED_CURVE_MAX >> 5]);
+  }
+  uint8_t index = speed >> 5;
+  uint8_t fraction = speed & 0x1F;
+  uint32_t from = pgm_read_dword(&SPEED_CURVE_STEP_RATE[index]);
+  uint32_t to = pgm_read_dword(&SPEED_CURVE_STEP_RATE[index + 1]);
+  return from - (((from - to) * fraction) >> 5);
+}
+
+/**
+ * Maps a speed of the full range (0 - 1024) onto the part of the curve from
+ * min_speed to 10 s, so the whole range of the potentiometer changes the
+ * period of an effect that can not step faster than its frame.
+ * @param speed Speed value, as provided by the potentiometer
+ * @param min_speed Speed of the curve at speed 0, for example SPEED_CURVE_20MS
+ * @return Speed value of the curve
+ */
+uint16_t speedFrom(uint16_t speed, uint16_t min_speed)
+{
+  if(speed >= SPEED_CURVE_MAX)
+  {
+    return SPEED_CURVE_MAX;
+  }
+  return min_speed + (((uint32_t)speed * (SPEED_CURVE_MAX - min_speed)) >> 10);
+}
@@ -0,0 +1,37 @@
+/*
+ * SpeedCurve.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef SPEED_CURVE_H_
+#define SPEED_CURVE_H_
+
+/**
+ * Fractional bits of the effect phase. The integer part of a phase counts
+ * whole effect steps (one color of the Flash sequence, one segment of the
+ * Fade wheel) and the fraction is the progress inside the current step.
+ */
+#define SPEED_CURVE_PHASE_BITS 20
+#define SPEED_CURVE_PHASE_ONE (1UL << SPEED_CURVE_PHASE_BITS)
+
+/**
+ * Maximum speed value accepted by the curve (full scale of the potentiometer).
+ */
+#define SPEED_CURVE_MAX 1024
+
+/**
+ * Speeds of the curve with a period of 10 and 20 ms (256 * log10 of the
+ * period), the fastest step of an effect that changes once per frame.
+ */
+#define SPEED_CURVE_10MS 256
+#define SPEED_CURVE_20MS 335
+
+uint32_t speedToStepRate(uint16_t speed);
+uint16_t speedFrom(uint16_t speed, uint16_t min_speed);
+
+#endif /* SPEED_CURVE_H_ */
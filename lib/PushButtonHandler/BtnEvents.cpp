@@ -0,0 +1,64 @@
+/*
+ * BtnEvents.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "BtnEvents.h"
+
+/**
+ * Adds a listener of the events.
+ * @param listener Function that receives the context and the event
+ * @param context Pointer passed to the listener
+ * @return false if there is no room for more listeners
+ */
+bool BtnEventBus::subscribe(BtnListener listener, void *context)
+{
+  if(this->_listeners_count >= BTN_MAX_LISTENERS)
+  {
+    return false;
+  }
+  this->_listeners[this->_listeners_count] = listener;
+  this->_contexts[this->_listeners_count] = context;
+  this->_listeners_count++;
+  return true;
+}
+
+/**
+ * Adds an event to the queue.
+ * @param button Identifier of the button
+ * @param type Type of the event
+ * @param count Number of clicks or hold ticks
+ * @return false if the queue is full and the event was dropped
+ */
+bool BtnEventBus::post(uint8_t button, BtnEventType type, uint8_t count)
+{
+  uint8_t head = this->_head;
+  uint8_t next = (head + 1) & (BTN_EVENT_QUEUE_SIZE - 1);
+  if(next == this->_tail)
+  {
+    return false;
+  }
+  this->_queue[head].button = button;
+  this->_queue[head].type = type;
+  this->_queue[head].count = count;
+  this->_head = next;
+  return true;
+}
+
+/**
+ * Delivers the queued events to all the listeners, in order.
+ */
+void BtnEventBus::dispatch(void)
+{
+  while(this->_tail != this->_head)
+  {
+    BtnEvent event = this->_queue[this->_tail];
+    this->_tail = (this->_tail + 1) & (BTN_EVENT_QUEUE_SIZE - 1);
+    for(uint8_t i = 0; i < this->_listeners_count; i++)
+    {
+      this->_listeners[i](this->_contexts[i], event);
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/*
+ * BtnEvents.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef BTN_EVENTS_H_
+#define BTN_EVENTS_H_
+
+// Size of the queue of events, it must be a power of two
+#define BTN_EVENT_QUEUE_SIZE 8
+#define BTN_MAX_LISTENERS 4
+
+/**
+ * Types of the events of a button.
+ *  - PRESS: the button was pressed.
+ *  - RELEASE: the button was released.
+ *  - CLICK: one or more consecutive short presses, count has the number.
+ *  - LONG_PRESS: the button is held down longer than the long press delay.
+ *  - HOLD: periodic tick while the button is still held after a long press,
+ *    count has the number of ticks.
+ */
+enum BtnEventType : uint8_t
+{
+  PRESS,
+  RELEASE,
+  CLICK,
+  LONG_PRESS,
+  HOLD
+};
+
+/**
+ * An event in the queue (3 bytes).
+ */
+struct BtnEvent
+{
+  uint8_t button;
+  BtnEventType type;
+  uint8_t count;
+};
+
+typedef void (*BtnListener)(void *context, BtnEvent event);
+
+/**
+ * BtnEventBus keeps the events of the buttons in a queue until dispatch() is
+ * called, so the listeners run at a safe point of the loop instead of while
+ * the inputs are read. Several listeners can receive the events, each with
+ * its own context pointer.
+ */
+class BtnEventBus
+{
+  private:
+    BtnEvent _queue[BTN_EVENT_QUEUE_SIZE];
+    volatile uint8_t _head = 0;
+    volatile uint8_t _tail = 0;
+    BtnListener _listeners[BTN_MAX_LISTENERS];
+    void *_contexts[BTN_MAX_LISTENERS];
+    uint8_t _listeners_count = 0;
+
+  public:
+    bool subscribe(BtnListener, void*);
+    bool post(uint8_t, BtnEventType, uint8_t);
+    void dispatch(void);
+};
+
+#endif /* BTN_EVENTS_H_ */
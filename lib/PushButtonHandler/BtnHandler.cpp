@@ -8,11 +8,19 @@
 #include "BtnHandler.h"
 #include <Arduino.h>
 
-BtnHandler::BtnHandler(uint8_t pin, void(*shortFn)(void), void(*longFn)(void))
+BtnHandler *BtnHandler::_interrupt_handlers[BTN_MAX_INTERRUPT_HANDLERS];
+uint8_t BtnHandler::_interrupt_handlers_count = 0;
+
+/**
+ * Constructor of the class.
+ * @param pin Pin of the button
+ * @param id Identifier of the button in its events
+ * @param bus Queue that receives the events of the button
+ */
+BtnHandler::BtnHandler(uint8_t pin, uint8_t id, BtnEventBus &bus) : _bus(bus)
 {
   this->_pin = pin;
-  this->_short_function_pointer = shortFn;
-  this->_long_function_pointer = longFn;
+  this->_id = id;
 }
 
 void BtnHandler::activateWith(uint8_t level)
@@ -20,50 +28,135 @@ void BtnHandler::activateWith(uint8_t level)
   this->_activate_with = level;
 }
 
+/**
+ * Time to wait for another click before the CLICK event is sent. With 0 each
+ * click is sent alone as soon as the button is released.
+ */
+void BtnHandler::setClickDelay(uint32_t delay)
+{
+  this->_click_delay = delay;
+}
+
 void BtnHandler::setup(void)
 {
   pinMode(this->_pin, INPUT_PULLUP);
 }
 
+/**
+ * Enables the pin change interruption of the button. The buttons share the
+ * interruption of the port B, and while a button is idle its loop() returns
+ * without reading the pin.
+ * @return false if the pin change interruption is not available
+ */
+bool BtnHandler::attachInterrupt(void)
+{
+  if(this->_interrupt)
+  {
+    return true;
+  }
+  if(_interrupt_handlers_count >= BTN_MAX_INTERRUPT_HANDLERS)
+  {
+    return false;
+  }
+#if defined(__AVR_ATtiny85__)
+  PCMSK |= _BV(this->_pin);
+  GIMSK |= _BV(PCIE);
+#elif defined(PCMSK0)
+  if(this->_pin < 8 || this->_pin > 13)
+  {
+    return false;
+  }
+  PCMSK0 |= _BV(this->_pin - 8);
+  PCICR |= _BV(PCIE0);
+#else
+  return false;
+#endif
+  _interrupt_handlers[_interrupt_handlers_count++] = this;
+  this->_interrupt = true;
+  this->_changed = true;
+  return true;
+}
+
 void BtnHandler::loop(void)
 {
+  if(this->_interrupt && !this->_changed && !this->_short_pressed &&
+    this->_clicks == 0)
+  {
+    return;
+  }
+  this->_changed = false;
+  uint32_t now = millis();
   if(digitalRead(this->_pin) == this->_activate_with)
   {
     if(this->_short_pressed == false)
     {
       this->_short_pressed = true;
-      this->_last_time_pressed = millis();
+      this->_last_time_pressed = now;
+      this->_bus.post(this->_id, BtnEventType::PRESS, 0);
+    }
+    if(!this->_long_pressed)
+    {
+      if(now - this->_last_time_pressed > this->_long_press_delay)
+      {
+        this->_long_pressed = true;
+        this->_clicks = 0;
+        this->_holds = 0;
+        this->_last_time_hold = now;
+        this->_bus.post(this->_id, BtnEventType::LONG_PRESS, 0);
+      }
     }
-    if((millis() - this->_last_time_pressed > this->_long_press_delay) && !this->_long_pressed)
+    else if(now - this->_last_time_hold >= this->_hold_delay)
     {
-      this->_long_pressed = true;
-      this->_long_function_pointer();
+      this->_last_time_hold = now;
+      this->_holds++;
+      this->_bus.post(this->_id, BtnEventType::HOLD, this->_holds);
     }
   }
-  else
+  else if(this->_short_pressed)
   {
-    if(this->_short_pressed)
+    this->_short_pressed = false;
+    this->_bus.post(this->_id, BtnEventType::RELEASE, 0);
+    if(this->_long_pressed)
     {
-      if(this->_long_pressed)
-      {
-        this->_long_pressed = false;
-      }
-      else
-      {
-        if((millis() - this->_last_time_pressed) > this->_debounce_delay)
-        {
-          this->_short_function_pointer();
-        }
-      }
-      this->_short_pressed = false;
+      this->_long_pressed = false;
+    }
+    else if((now - this->_last_time_pressed) > this->_debounce_delay)
+    {
+      this->_clicks++;
+      this->_last_time_released = now;
     }
   }
+  if(this->_clicks > 0 && !this->_short_pressed &&
+    (now - this->_last_time_released) >= this->_click_delay)
+  {
+    this->_bus.post(this->_id, BtnEventType::CLICK, this->_clicks);
+    this->_clicks = 0;
+  }
 }
 
+/**
+ * Marks a change in the pin of the button, so the next loop() reads it.
+ */
 void BtnHandler::interruption(void)
 {
-  if((millis() - this->_last_time_pressed) > this->_debounce_delay)
+  this->_changed = true;
+}
+
+/**
+ * Notifies the change of the port to all the buttons with the interruption
+ * attached. It is called from the pin change interruption.
+ */
+void BtnHandler::pinChanged(void)
+{
+  for(uint8_t i = 0; i < _interrupt_handlers_count; i++)
   {
-    this->_short_function_pointer();
+    _interrupt_handlers[i]->interruption();
   }
 }
+
+#if defined(__AVR__) && defined(PCINT0_vect)
+ISR(PCINT0_vect)
+{
+  BtnHandler::pinChanged();
+}
+#endif
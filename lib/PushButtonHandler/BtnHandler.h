@@ -7,29 +7,46 @@
  */
 
 #include <inttypes.h>
+#include "BtnEvents.h"
 
 #ifndef BTN_HANDLER_H_
 #define BTN_HANDLER_H_
 
+// Buttons that can share the pin change interruption of the port B
+#define BTN_MAX_INTERRUPT_HANDLERS 4
+
 class BtnHandler
 {
 private:
   uint8_t _pin;
+  uint8_t _id;
+  BtnEventBus &_bus;
   uint32_t _debounce_delay = 100;
   uint32_t _long_press_delay = 500;
+  uint32_t _hold_delay = 200;
+  uint32_t _click_delay = 300;
   uint32_t _last_time_pressed = 0;
+  uint32_t _last_time_released = 0;
+  uint32_t _last_time_hold = 0;
   bool _short_pressed = false;
   bool _long_pressed = false;
   uint8_t _activate_with = 1;
+  uint8_t _clicks = 0;
+  uint8_t _holds = 0;
+  bool _interrupt = false;
+  volatile bool _changed = false;
 
-  void(*_short_function_pointer)(void);
-  void(*_long_function_pointer)(void);
+  static BtnHandler *_interrupt_handlers[BTN_MAX_INTERRUPT_HANDLERS];
+  static uint8_t _interrupt_handlers_count;
 public:
-  BtnHandler(uint8_t, void (*)(void), void (*)(void));
+  BtnHandler(uint8_t, uint8_t, BtnEventBus&);
   void activateWith(uint8_t);
+  void setClickDelay(uint32_t);
   void setup(void);
+  bool attachInterrupt(void);
   void loop(void);
   void interruption(void);
+  static void pinChanged(void);
 };
 
 #endif /* BTN_HANDLER_H_ */
@@ -0,0 +1,168 @@
+/*
+ * ButtonBank.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "ButtonBank.h"
+#include <Arduino.h>
+
+/**
+ * Constructor of the class.
+ * @param bus Queue that receives the events of the buttons
+ */
+ButtonBank::ButtonBank(BtnEventBus &bus) : _bus(bus)
+{
+}
+
+/**
+ * Adds a button to the bank.
+ * @param pin Pin of the button, it must belong to the port B
+ * @param id Identifier of the button in its events
+ * @return Index of the button, 0xFF if there is no room for it
+ */
+uint8_t ButtonBank::addButton(uint8_t pin, uint8_t id)
+{
+  if(this->_count >= BANK_MAX_BUTTONS)
+  {
+    return 0xFF;
+  }
+  uint8_t index = this->_count++;
+  this->_pins[index] = pin;
+  this->_ids[index] = id;
+  this->_masks[index] = digitalPinToBitMask(pin);
+  this->_port_mask |= this->_masks[index];
+  this->_clicks[index] = 0;
+  this->_holds[index] = 0;
+  return index;
+}
+
+/**
+ * Level of the pins when the buttons are pressed, the same for all of them.
+ */
+void ButtonBank::activateWith(uint8_t level)
+{
+  this->_activate_with = level;
+}
+
+/**
+ * Time to wait for another click before the CLICK event is sent.
+ */
+void ButtonBank::setClickDelay(uint16_t delay)
+{
+  this->_click_delay = delay;
+}
+
+void ButtonBank::setup(void)
+{
+  for(uint8_t i = 0; i < this->_count; i++)
+  {
+    pinMode(this->_pins[i], INPUT_PULLUP);
+  }
+}
+
+/**
+ * Reads the buttons, a bit set for each pressed button.
+ */
+uint8_t ButtonBank::readPort(void)
+{
+#if defined(__AVR__)
+  uint8_t port = PINB;
+#else
+  uint8_t port = 0;
+  for(uint8_t i = 0; i < this->_count; i++)
+  {
+    if(digitalRead(this->_pins[i]))
+    {
+      port |= this->_masks[i];
+    }
+  }
+#endif
+  if(this->_activate_with == 0)
+  {
+    port = ~port;
+  }
+  return port & this->_port_mask;
+}
+
+/**
+ * Reads and debounces all the buttons, then sends the events of the buttons
+ * that changed or are waiting for a timeout. It should be called every few
+ * milliseconds (a change is accepted after four scans).
+ */
+void ButtonBank::scan(void)
+{
+  uint8_t changed = this->_state ^ this->readPort();
+  this->_counter0 = ~(this->_counter0 & changed);
+  this->_counter1 = this->_counter0 ^ (this->_counter1 & changed);
+  changed &= this->_counter0 & this->_counter1;
+  this->_state ^= changed;
+
+  uint8_t pending = changed | this->_busy;
+  if(pending == 0)
+  {
+    return;
+  }
+  uint16_t now = millis();
+  for(uint8_t i = 0; i < this->_count; i++)
+  {
+    if(pending & this->_masks[i])
+    {
+      this->update(i, this->_masks[i], changed & this->_masks[i], now);
+    }
+  }
+}
+
+/**
+ * Follows the gestures of a button that changed or has pending timeouts.
+ */
+void ButtonBank::update(uint8_t index, uint8_t mask, uint8_t changed, uint16_t now)
+{
+  uint8_t id = this->_ids[index];
+  if(this->_state & mask)
+  {
+    if(changed)
+    {
+      this->_last_time_changed[index] = now;
+      this->_busy |= mask;
+      this->_bus.post(id, BtnEventType::PRESS, 0);
+    }
+    else if(!(this->_long_pressed & mask))
+    {
+      if((uint16_t)(now - this->_last_time_changed[index]) > this->_long_press_delay)
+      {
+        this->_long_pressed |= mask;
+        this->_clicks[index] = 0;
+        this->_holds[index] = 0;
+        this->_last_time_hold[index] = now;
+        this->_bus.post(id, BtnEventType::LONG_PRESS, 0);
+      }
+    }
+    else if((uint16_t)(now - this->_last_time_hold[index]) >= this->_hold_delay)
+    {
+      this->_last_time_hold[index] = now;
+      this->_bus.post(id, BtnEventType::HOLD, ++this->_holds[index]);
+    }
+  }
+  else if(changed)
+  {
+    this->_last_time_changed[index] = now;
+    this->_bus.post(id, BtnEventType::RELEASE, 0);
+    if(this->_long_pressed & mask)
+    {
+      this->_long_pressed &= ~mask;
+      this->_busy &= ~mask;
+    }
+    else
+    {
+      this->_clicks[index]++;
+    }
+  }
+  else if((uint16_t)(now - this->_last_time_changed[index]) >= this->_click_delay)
+  {
+    this->_bus.post(id, BtnEventType::CLICK, this->_clicks[index]);
+    this->_clicks[index] = 0;
+    this->_busy &= ~mask;
+  }
+}
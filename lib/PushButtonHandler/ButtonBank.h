@@ -0,0 +1,63 @@
+/*
+ * ButtonBank.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+#include "BtnEvents.h"
+
+#ifndef BUTTON_BANK_H_
+#define BUTTON_BANK_H_
+
+#define BANK_MAX_BUTTONS 4
+
+/**
+ * ButtonBank handles up to BANK_MAX_BUTTONS buttons of the port B with a
+ * single read of the port per scan. All the buttons are debounced in parallel
+ * with a vertical counter (a 2 bits counter per button, stored bit-sliced in
+ * two bytes), a change is accepted after four equal scans. The events are the
+ * same of BtnHandler and are posted to a BtnEventBus.
+ */
+class ButtonBank
+{
+  private:
+    BtnEventBus &_bus;
+    uint8_t _pins[BANK_MAX_BUTTONS];
+    uint8_t _ids[BANK_MAX_BUTTONS];
+    uint8_t _masks[BANK_MAX_BUTTONS];
+    uint8_t _count = 0;
+    uint8_t _port_mask = 0;
+    uint8_t _activate_with = 1;
+
+    uint8_t _state = 0;
+    uint8_t _counter0 = 0xFF;
+    uint8_t _counter1 = 0xFF;
+    uint8_t _long_pressed = 0;
+    uint8_t _busy = 0;
+
+    // Times in milliseconds of 16 bits, the differences are taken modulo
+    // 2^16 so they stay right while millis() wraps (65 s)
+    uint16_t _long_press_delay = 500;
+    uint16_t _hold_delay = 200;
+    uint16_t _click_delay = 300;
+    uint16_t _last_time_changed[BANK_MAX_BUTTONS];
+    uint16_t _last_time_hold[BANK_MAX_BUTTONS];
+    uint8_t _clicks[BANK_MAX_BUTTONS];
+    uint8_t _holds[BANK_MAX_BUTTONS];
+
+    uint8_t readPort(void);
+    void update(uint8_t, uint8_t, uint8_t, uint16_t);
+
+  public:
+    ButtonBank(BtnEventBus &bus);
+    uint8_t addButton(uint8_t, uint8_t);
+    void activateWith(uint8_t);
+    void setClickDelay(uint16_t);
+    void setup(void);
+    void scan(void);
+};
+
+#endif /* BUTTON_BANK_H_ */
@@ -0,0 +1,198 @@
+/*
+ * SoftRTC.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "SoftRTC.h"
+#include <Arduino.h>
+#if defined(__AVR__)
+#include <avr/wdt.h>
+#include <avr/sleep.h>
+#if !defined(WDTCSR)
+#define WDTCSR WDTCR
+#endif
+#endif
+
+// Clock that receives the ticks of the watchdog interruption
+static SoftRTC *soft_rtc_instance = nullptr;
+
+/**
+ * Starts the watchdog in interruption mode with a period of one second, with
+ * the reset enabled it runs in interruption and reset mode.
+ */
+void SoftRTC::begin(void)
+{
+  soft_rtc_instance = this;
+#if defined(__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  wdt_reset();
+  WDTCSR |= _BV(WDCE) | _BV(WDE);
+  WDTCSR = _BV(WDIE) | _BV(WDP2) | _BV(WDP1) |
+    (this->_reset_enable ? _BV(WDE) : 0);
+  SREG = sreg;
+#endif
+}
+
+/**
+ * Allows the watchdog to reset the MCU when the application stops calling
+ * feed(). It must be set before begin().
+ * @param enabled Set true to reset the MCU
+ */
+void SoftRTC::setWatchdogResetEnable(bool enabled)
+{
+  this->_reset_enable = enabled;
+}
+
+/**
+ * Tells the watchdog that the application is running, it must be called
+ * more often than once per second (for example on every frame).
+ */
+void SoftRTC::feed(void)
+{
+  this->_fed = true;
+}
+
+/**
+ * Allows to set the time of day.
+ * @param minutes Minutes since midnight (0 - 1439)
+ */
+void SoftRTC::setTime(uint16_t minutes)
+{
+  noInterrupts();
+  this->_ticks = 0;
+  interrupts();
+  this->_seconds = (uint32_t)(minutes % MINUTES_PER_DAY) * 60;
+  this->_fraction = 0;
+  this->_minute = minutes % MINUTES_PER_DAY;
+  this->_set = true;
+}
+
+/**
+ * It allows to know if the time was set since the start.
+ */
+bool SoftRTC::isSet(void)
+{
+  return this->_set;
+}
+
+/**
+ * It allows to obtain the minutes since midnight.
+ */
+uint16_t SoftRTC::getMinutes(void)
+{
+  return this->_minute;
+}
+
+/**
+ * It allows to obtain the seconds since midnight.
+ */
+uint32_t SoftRTC::getSeconds(void)
+{
+  return this->_seconds;
+}
+
+/**
+ * It allows to obtain the measured period of the watchdog tick in
+ * milliseconds (x16).
+ */
+uint16_t SoftRTC::getTickPeriod(void)
+{
+  return this->_tick_period;
+}
+
+/**
+ * Counts the ticks of the watchdog since the last call. A tick measured alone
+ * between two calls corrects the calibration by 1/8 of its error.
+ * @return true when the minute changed
+ */
+bool SoftRTC::update(void)
+{
+  noInterrupts();
+  uint8_t ticks = this->_ticks;
+  uint32_t tick_time = this->_tick_time;
+  this->_ticks = 0;
+  interrupts();
+  if(ticks == 0)
+  {
+    return false;
+  }
+  if(ticks == 1 && this->_calibrated)
+  {
+    uint32_t measured = tick_time - this->_last_tick_time;
+    if(measured > 500 && measured < 2000)
+    {
+      int16_t error = (int16_t)(measured << 4) - this->_tick_period;
+      this->_tick_period += error >> 3;
+    }
+  }
+  this->_last_tick_time = tick_time;
+  this->_calibrated = true;
+
+  uint32_t fraction = this->_fraction + (uint32_t)ticks * this->_tick_period;
+  while(fraction >= RTC_TICK_PERIOD)
+  {
+    fraction -= RTC_TICK_PERIOD;
+    if(++this->_seconds >= SECONDS_PER_DAY)
+    {
+      this->_seconds = 0;
+    }
+  }
+  this->_fraction = fraction;
+  uint16_t minute = this->_seconds / 60;
+  if(minute == this->_minute)
+  {
+    return false;
+  }
+  this->_minute = minute;
+  return true;
+}
+
+/**
+ * Counts a tick of the watchdog, it is called from its interruption.
+ */
+void SoftRTC::tick(void)
+{
+  this->_ticks++;
+  this->_tick_time = millis();
+#if defined(__AVR__)
+  // In reset mode the timeout clears WDIE, the next one resets the MCU
+  // unless it is set again
+  if(this->_reset_enable && this->_fed)
+  {
+    this->_fed = false;
+    WDTCSR |= _BV(WDIE);
+  }
+#endif
+}
+
+/**
+ * Waits for the given time with the CPU in idle mode. The timers keep running,
+ * so the PWM outputs are not affected.
+ * @param time Milliseconds to wait
+ */
+void SoftRTC::idle(uint16_t time)
+{
+  uint32_t start = millis();
+  while((millis() - start) < time)
+  {
+#if defined(__AVR__)
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+#else
+    delay(1);
+#endif
+  }
+}
+
+#if defined(__AVR__)
+ISR(WDT_vect)
+{
+  if(soft_rtc_instance != nullptr)
+  {
+    soft_rtc_instance->tick();
+  }
+}
+#endif
@@ -0,0 +1,58 @@
+/*
+ * SoftRTC.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef SOFT_RTC_H_
+#define SOFT_RTC_H_
+
+#define SECONDS_PER_DAY 86400UL
+#define MINUTES_PER_DAY 1440
+
+// Nominal period of the watchdog tick in milliseconds (x16)
+#define RTC_TICK_PERIOD (1000 << 4)
+
+/**
+ * SoftRTC keeps the time of day with the watchdog interruption (a tick per
+ * second), so it keeps counting while the CPU sleeps. The watchdog oscillator
+ * is not accurate, so the real length of each tick is measured against the
+ * system clock while the CPU is awake and averaged.
+ * With the watchdog reset enabled it also supervises the application: each
+ * tick arms the next one only if feed() was called since the previous tick,
+ * otherwise the following timeout resets the MCU (in 1 - 2 seconds).
+ */
+class SoftRTC
+{
+  private:
+    volatile uint8_t _ticks = 0;
+    volatile uint32_t _tick_time = 0;
+    uint32_t _last_tick_time = 0;
+    bool _calibrated = false;
+    uint16_t _tick_period = RTC_TICK_PERIOD;
+    uint16_t _fraction = 0;
+    uint32_t _seconds = 0;
+    uint16_t _minute = 0;
+    bool _set = false;
+    bool _reset_enable = false;
+    volatile bool _fed = true;
+
+  public:
+    void begin(void);
+    void setWatchdogResetEnable(bool);
+    void feed(void);
+    void setTime(uint16_t);
+    bool isSet(void);
+    uint16_t getMinutes(void);
+    uint32_t getSeconds(void);
+    uint16_t getTickPeriod(void);
+    bool update(void);
+    void tick(void);
+    void idle(uint16_t);
+};
+
+#endif /* SOFT_RTC_H_ */
@@ -0,0 +1,229 @@
+/*
+ * Supervisor.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+#include "Supervisor.h"
+#include <Arduino.h>
+#include <string.h>
+#if defined(__AVR__)
+#include <avr/wdt.h>
+#endif
+
+/**
+ * Data kept across the resets, the checksums tell random data from a record
+ * written before the reset. The snapshot is built in place by the
+ * application, it is aligned for any of its fields.
+ */
+struct SupervisorRecord
+{
+  ResetDiagnostics diagnostics;
+  uint16_t diagnostics_check;
+  uint16_t snapshot_check;
+  uint32_t snapshot[SUPERVISOR_SNAPSHOT_SIZE / 4];
+  uint8_t size;
+};
+
+static SupervisorRecord supervisor_record __attribute__((section(".noinit")));
+
+#if defined(__AVR__)
+// Reset flags saved before the C runtime initialization
+static uint8_t reset_flags __attribute__((section(".noinit")));
+
+/**
+ * Saves and clears the reset flags and stops the watchdog, it runs from the
+ * .init3 section before the variables are initialized.
+ */
+static void readResetFlags(void) __attribute__((naked, used, section(".init3")));
+static void readResetFlags(void)
+{
+  reset_flags = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+#endif
+
+/**
+ * Fletcher-16 checksum, the sums do not start at 0 so a cleared SRAM is not
+ * a valid record. The sums are reduced modulo 255 once every
+ * SUPERVISOR_CHECKSUM_BLOCK bytes (an add of the carry, no division), the
+ * result is the same of a reduction on every byte.
+ */
+static uint16_t checksum(const void *data, uint8_t length)
+{
+  const uint8_t *bytes = static_cast<const uint8_t*>(data);
+  uint16_t sum1 = 0x5A;
+  uint16_t sum2 = 0xA5;
+  while(length > 0)
+  {
+    uint8_t block = length < SUPERVISOR_CHECKSUM_BLOCK ? length : SUPERVISOR_CHECKSUM_BLOCK;
+    length -= block;
+    do
+    {
+      sum1 += *bytes++;
+      sum2 += sum1;
+    } while(--block);
+    sum1 = (sum1 & 0xFF) + (sum1 >> 8);
+    sum2 = (sum2 & 0xFF) + (sum2 >> 8);
+  }
+  sum1 = (sum1 & 0xFF) + (sum1 >> 8);
+  sum2 = (sum2 & 0xFF) + (sum2 >> 8);
+  if(sum1 >= 255)
+  {
+    sum1 -= 255;
+  }
+  if(sum2 >= 255)
+  {
+    sum2 -= 255;
+  }
+  return (sum2 << 8) | sum1;
+}
+
+/**
+ * Finds the cause of the reset and counts it. After a power on the
+ * diagnostics start from zero and there is no snapshot.
+ */
+void Supervisor::begin(void)
+{
+  ResetDiagnostics &diagnostics = supervisor_record.diagnostics;
+#if defined(__AVR__)
+  if(reset_flags & _BV(PORF))
+  {
+    this->_cause = ResetCause::RESET_POWER_ON;
+  }
+  else if(reset_flags & _BV(WDRF))
+  {
+    this->_cause = ResetCause::RESET_WATCHDOG;
+  }
+  else if(reset_flags & _BV(BORF))
+  {
+    this->_cause = ResetCause::RESET_BROWN_OUT;
+  }
+  else if(reset_flags & _BV(EXTRF))
+  {
+    this->_cause = ResetCause::RESET_EXTERNAL;
+  }
+#endif
+  if(this->_cause == ResetCause::RESET_POWER_ON ||
+    checksum(&diagnostics, sizeof(ResetDiagnostics)) !=
+    supervisor_record.diagnostics_check)
+  {
+    memset(&diagnostics, 0, sizeof(ResetDiagnostics));
+  }
+  if(this->_cause == ResetCause::RESET_POWER_ON)
+  {
+    this->clear();
+  }
+  switch (this->_cause) {
+    case ResetCause::RESET_EXTERNAL:
+      diagnostics.external++;
+      break;
+    case ResetCause::RESET_BROWN_OUT:
+      diagnostics.brown_out++;
+      break;
+    case ResetCause::RESET_WATCHDOG:
+      diagnostics.watchdog++;
+      break;
+    case ResetCause::RESET_UNKNOWN:
+      diagnostics.unknown++;
+      break;
+    default:
+      break;
+  }
+  diagnostics.cause = this->_cause;
+  diagnostics.total++;
+  this->writeDiagnostics();
+}
+
+void Supervisor::writeDiagnostics(void)
+{
+  supervisor_record.diagnostics_check = checksum(&supervisor_record.diagnostics,
+    sizeof(ResetDiagnostics));
+}
+
+/**
+ * It allows to obtain the cause of the last reset.
+ */
+ResetCause Supervisor::getResetCause(void)
+{
+  return this->_cause;
+}
+
+/**
+ * It allows to obtain the counters of the resets since the last power on.
+ */
+ResetDiagnostics Supervisor::getDiagnostics(void)
+{
+  return supervisor_record.diagnostics;
+}
+
+/**
+ * Copies the snapshot saved before the reset.
+ * @param data Destination of the snapshot
+ * @param size Size of the snapshot, it must be the saved one
+ * @return false if there is no valid snapshot, data is not changed
+ */
+bool Supervisor::restore(void *data, uint8_t size)
+{
+  ResetDiagnostics &diagnostics = supervisor_record.diagnostics;
+  if(size != supervisor_record.size || size > SUPERVISOR_SNAPSHOT_SIZE ||
+    checksum(supervisor_record.snapshot, size) != supervisor_record.snapshot_check)
+  {
+    return false;
+  }
+  if(diagnostics.restores >= SUPERVISOR_MAX_RESTORES)
+  {
+    // The state itself may be the cause of the resets
+    this->clear();
+    return false;
+  }
+  diagnostics.restores++;
+  this->writeDiagnostics();
+  memcpy(data, supervisor_record.snapshot, size);
+  return true;
+}
+
+/**
+ * Gives the buffer of the snapshot in the record, the application writes its
+ * state there and then calls commit(). It is meant to be called on every
+ * frame. Once the application runs SUPERVISOR_STABLE_TIME the restores in a
+ * row are cleared.
+ * @param size Size of the snapshot, up to SUPERVISOR_SNAPSHOT_SIZE bytes
+ * @return Buffer of the snapshot, nullptr if the size does not fit
+ */
+void *Supervisor::edit(uint8_t size)
+{
+  if(size > SUPERVISOR_SNAPSHOT_SIZE)
+  {
+    return nullptr;
+  }
+  if(!this->_stable && millis() >= SUPERVISOR_STABLE_TIME)
+  {
+    this->_stable = true;
+    supervisor_record.diagnostics.restores = 0;
+    this->writeDiagnostics();
+  }
+  supervisor_record.size = size;
+  return supervisor_record.snapshot;
+}
+
+/**
+ * Seals the snapshot written after edit(). A reset while it is written
+ * leaves a snapshot with a wrong checksum.
+ */
+void Supervisor::commit(void)
+{
+  supervisor_record.snapshot_check = checksum(supervisor_record.snapshot,
+    supervisor_record.size);
+}
+
+/**
+ * Drops the snapshot, the next start uses the defaults.
+ */
+void Supervisor::clear(void)
+{
+  supervisor_record.size = 0;
+  supervisor_record.snapshot_check = ~checksum(supervisor_record.snapshot, 0);
+}
@@ -0,0 +1,80 @@
+/*
+ * Supervisor.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+#include <inttypes.h>
+
+#ifndef SUPERVISOR_H_
+#define SUPERVISOR_H_
+
+// Largest snapshot of the application kept across a reset, in bytes (a
+// multiple of 4)
+#define SUPERVISOR_SNAPSHOT_SIZE 32
+// Bytes added to the 16 bits sums of the checksum before they overflow
+#define SUPERVISOR_CHECKSUM_BLOCK 20
+// Restores in a row without a stable run, then the snapshot is dropped
+#define SUPERVISOR_MAX_RESTORES 3
+// Milliseconds of run after which a restored state is taken as stable
+#define SUPERVISOR_STABLE_TIME 10000
+
+/**
+ * Cause of the last reset, from the reset flags (MCUSR). It is unknown when
+ * the flags were cleared before the start, for example by a bootloader.
+ */
+enum ResetCause
+{
+  RESET_UNKNOWN,
+  RESET_POWER_ON,
+  RESET_EXTERNAL,
+  RESET_BROWN_OUT,
+  RESET_WATCHDOG
+};
+
+/**
+ * Counters of the causes of the resets since the last power on (12 bytes).
+ */
+struct ResetDiagnostics
+{
+  uint8_t cause;
+  uint8_t restores;
+  uint16_t external;
+  uint16_t brown_out;
+  uint16_t watchdog;
+  uint16_t unknown;
+  uint16_t total;
+};
+
+/**
+ * Supervisor keeps the diagnostics of the resets and a snapshot of the state
+ * of the application in the SRAM that is not cleared on start (.noinit), each
+ * one protected by a checksum. A power on leaves random data in the SRAM, so
+ * both are cleared, after any other reset (watchdog, brown-out, external) a
+ * valid snapshot can be restored so the application resumes where it was.
+ * If the restored state leads to SUPERVISOR_MAX_RESTORES resets in a row, the
+ * snapshot is dropped and the application starts from its defaults.
+ * The reset flags are read and the watchdog is stopped before the C runtime
+ * initialization, a watchdog reset leaves it running with its shortest period.
+ */
+class Supervisor
+{
+  private:
+    ResetCause _cause = ResetCause::RESET_UNKNOWN;
+    bool _stable = false;
+
+    void writeDiagnostics(void);
+
+  public:
+    void begin(void);
+    ResetCause getResetCause(void);
+    ResetDiagnostics getDiagnostics(void);
+    bool restore(void*, uint8_t);
+    void *edit(uint8_t);
+    void commit(void);
+    void clear(void);
+};
+
+#endif /* SUPERVISOR_H_ */
@@ -0,0 +1,67 @@
+#
+# size_report.py
+# Created by Jose Rivera, Feb 2018.
+#
+# This work is licensed under a Creative Commons Attribution 4.0 International License.
+# http://creativecommons.org/licenses/by/4.0/
+#
+# Post build report of the memory of an AVR env (extra_scripts in
+# platformio.ini): the sections of the firmware (avr-size) against the flash
+# and the SRAM of the board, and the largest variables in SRAM (avr-nm). The
+# report is printed and written to size_report.txt in the build folder of
+# the env, so the envs can be compared after a build of all of them.
+#
+
+import os
+import subprocess
+
+Import("env")
+
+# Variables listed in the report, the largest first
+TOP_SYMBOLS = 12
+
+
+def run(command):
+    return subprocess.check_output(command, env=env["ENV"]).decode()
+
+
+def size_report(source, target, env):
+    elf = str(target[0])
+    size_tool = env.subst("$SIZETOOL") or "avr-size"
+    nm_tool = size_tool[:-len("size")] + "nm"
+    board = env.BoardConfig()
+    flash_max = int(board.get("upload.maximum_size", 0))
+    ram_max = int(board.get("upload.maximum_ram_size", 0))
+
+    sections = {}
+    for line in run([size_tool, "-A", "-d", elf]).splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sections[fields[0]] = int(fields[1])
+    flash = sections.get(".text", 0) + sections.get(".data", 0)
+    ram = sections.get(".data", 0) + sections.get(".bss", 0) + sections.get(".noinit", 0)
+
+    lines = ["Memory of %s (%s)" % (env["PIOENV"], board.get("build.mcu", "?"))]
+    lines.append("  flash %6d of %6d bytes (%.1f%%)" %
+                 (flash, flash_max, 100.0 * flash / flash_max if flash_max else 0))
+    lines.append("  sram  %6d of %6d bytes (%.1f%%), %d left for the stack" %
+                 (ram, ram_max, 100.0 * ram / ram_max if ram_max else 0, ram_max - ram))
+    for name in (".data", ".bss", ".noinit"):
+        lines.append("    %-8s %5d" % (name, sections.get(name, 0)))
+
+    symbols = []
+    for line in run([nm_tool, "-C", "-S", "--size-sort", "-r", elf]).splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in ("b", "B", "d", "D"):
+            symbols.append((int(fields[1], 16), fields[3]))
+    lines.append("  largest variables in SRAM:")
+    for size, name in symbols[:TOP_SYMBOLS]:
+        lines.append("    %5d  %s" % (size, name))
+
+    report = "\n".join(lines)
+    print(report)
+    with open(os.path.join(env.subst("$BUILD_DIR"), "size_report.txt"), "w") as output:
+        output.write(report + "\n")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", size_report)
@@ -18,8 +18,15 @@
  * with a brightness intensity determined by the value provided by the
  * potentiometer.
  *
+ * Color temperature mode
+ * While in the white light mode, pressing the button mixes the white LEDs with
+ * the RGB LEDs to show a white of 2200 K to 6500 K. Turning the potentiometer
+ * makes the light warmer or colder, turning it while the button is held down
+ * changes the brightness.
+ *
  * Color light mode
- * While in the white light mode, pressing the button switches to the color mode,
+ * While in the color temperature mode, pressing the button switches to the
+ * color mode,
  * that is, it turns off the white LED and shows the color defined by default
  * with the RGB LEDs, you can change the color of the LED strip by varying the
  * potentiometer value.
@@ -41,73 +48,236 @@
  * gradual than in Flash mode, but its speed can be modified by varying the
  * value of the potentiometer.
  *
+ * Candle, Fire and Twinkle modes
+ * While in Fade mode, pressing the button switches to Candle mode, then to Fire
+ * and Twinkle modes. They modulate the brightness with an organic noise: the
+ * wavering of a candle flame, the flickering of a fire in red and orange, and
+ * the sparkles of a steady light. Candle and Twinkle use the color set with the
+ * potentiometer.
+ *
+ * Music mode
+ * When a microphone or line input is connected to the potentiometer input
+ * (define MUSIC_INPUT), pressing the button while in Twinkle mode switches to
+ * Music mode. The bass, mid and high levels of the audio are shown in red,
+ * green and blue and the beats of the music are shown as white flashes.
+ *
+ * Scenes
+ * A triple click saves the current state of the LEDs (white or color, mode,
+ * color, speed and brightness) as a scene, up to 16 scenes are kept. A double
+ * click recalls the next saved scene with a cross fade.
+ *
+ * Schedule
+ * Five clicks set the clock to 19:00 (do it at that time of the day) and
+ * enable the schedule, four clicks enable or disable it. While enabled the
+ * LEDs follow the schedule table: warm white in the evening, dimming overnight
+ * and off by the morning. A single click or a long press disables it.
+ *
  * Off mode
  * If the button is held down for approximately one second, all the LEDs will
- * turn off. To turn on again you can press the button or modify the value of
- * the potentiometer.
+ * turn off when it is released. To turn on again you can press the button or
+ * modify the value of the potentiometer.
+ *
+ * Auto-brightness
+ * When a light sensor (an LDR divider on BOARD_LDR_PIN) is connected and
+ * AUTO_BRIGHTNESS is defined, the output of all the LEDs is scaled slowly so
+ * the light seen by the sensor stays at AMBIENT_TARGET: the LEDs dim with
+ * daylight and go up in the dark. The potentiometer keeps setting the
+ * brightness and the colors as before.
+ *
+ * Recovery
+ * The watchdog resets the driver if the program stops running. The state of
+ * the LEDs (mode, effect, color, brightness, clock and schedule) is kept on
+ * every frame in a part of the memory that survives a reset, so after a
+ * watchdog reset or a short brown-out the driver resumes at once where it was,
+ * without the test of the LEDs. After a power on it starts as usual.
+ *
+ * Boards
+ * The pins, the timing and the output of the LEDs come from the profile of the
+ * board in BoardProfile.h. The Digispark drives the LEDs with the BCM engine on
+ * Timer1, because blue on P3 has no hardware PWM.
  */
 
 #include <Arduino.h>
-#include "BtnHandler.h"
+#include "ButtonBank.h"
 #include "LedStrip.h"
 #include "LedStripRGB.h"
+#include "BoardOutput.h"
+#include "SceneStore.h"
+#include "PowerBudget.h"
+#include "LightSchedule.h"
+#include "CctWhite.h"
+#include "SoftRTC.h"
+#include "Supervisor.h"
+#include "AdcScheduler.h"
+#include "AutoBrightness.h"
 
 //uncomment this line if using a Common Anode LED
 //#define COMMON_ANODE
 
+//uncomment this line if the potentiometer input is used as audio input
+//#define MUSIC_INPUT
+
+//uncomment this line if a light sensor is connected to BOARD_LDR_PIN
+//#define AUTO_BRIGHTNESS
+
+#if defined(AUTO_BRIGHTNESS) && !defined(BOARD_LDR_PIN)
+#error "The board has no analog input for the light sensor"
+#endif
+
 // It allows to avoid that small variations of voltage turn on the light
 #define THRESHOLD_FOR_TURN_ON 100
 
-const uint8_t red_pin = 0; // P0
-const uint8_t green_pin = 1; // P1
-const uint8_t btn_mode_pin = 2; // P2
-const uint8_t blue_pin = 3; // P3
-const uint8_t white_pin = 4; // P4
-const uint8_t pot_color_pin = 0; // A0
+// Milliseconds to change the brightness from off to full and vice versa
+#define RAMP_TIME 300
+// Milliseconds of the blend between two RGB modes
+#define TRANSITION_TIME 400
+
+// Time of the day set by the clock set sequence (19:00)
+#define CLOCK_SET_TIME (19 * 60)
+
+// Light level held by the auto-brightness (ADC counts of the sensor)
+#define AMBIENT_TARGET 512
+
+// Length of the strip in decimeters
+#define STRIP_LENGTH 50
+// Current of each channel at full brightness in mA per meter
+#define CHANNEL_CURRENT 400
+// Maximum current of the supply and the MOSFETs in mA
+#define POWER_BUDGET 3000
+
+const uint8_t red_pin = BOARD_RED_PIN;
+const uint8_t green_pin = BOARD_GREEN_PIN;
+const uint8_t btn_mode_pin = BOARD_BTN_MODE_PIN;
+const uint8_t blue_pin = BOARD_BLUE_PIN;
+const uint8_t white_pin = BOARD_WHITE_PIN;
+const uint8_t pot_color_pin = BOARD_POT_PIN;
 
 // Set a default color for the color mode
 const uint32_t default_color = COLOR_DARKPURPLE;
 
+// Time of the last update of the LEDs
+uint32_t last_frame_time = 0;
+
 // Allows validation if there is a change in voltage
 uint16_t last_pot_color_value = 1;
+// Potentiometer reading filtered with a first order low pass (value x 4)
+uint16_t pot_color_filtered = 0;
 
+// Output of the LEDs selected by the profile of the board
+#ifdef BOARD_OUTPUT_ENGINE
+BoardOutput led_output(&BOARD_LED_PORT, &BOARD_LED_DDR);
+#else
+BoardOutput led_output;
+#endif
 // Instance that allows to handle the RGB leds of the strip of leds
-LedStripRGB led_strip_rgb({ red_pin, green_pin, blue_pin });
+LedStripRGB led_strip_rgb({ BOARD_CHANNEL(red_pin), BOARD_CHANNEL(green_pin),
+  BOARD_CHANNEL(blue_pin) }, led_output);
 // Instance that allows to handle the led of white light of the strip of leds
-LedStrip led_strip_w(white_pin);
+LedStrip led_strip_w(BOARD_CHANNEL(white_pin), led_output);
+// Instance that keeps the total current of the channels within the budget
+PowerBudget power_budget(POWER_BUDGET);
+// Points of the day of the schedule: minute, white, color (R, G, B) and mode
+const ScheduleEntry schedule_table[] PROGMEM = {
+  { 1 * 60, 30, { 0x00, 0x00, 0x00 }, LedStripRgbMode::NORMAL },
+  { 6 * 60, 0, { 0x00, 0x00, 0x00 }, LedStripRgbMode::NORMAL },
+  { 18 * 60, 0, { 0x00, 0x00, 0x00 }, LedStripRgbMode::NORMAL },
+  { 19 * 60, 255, { 0x40, 0x18, 0x00 }, LedStripRgbMode::NORMAL },
+  { 22 * 60, 160, { 0x30, 0x10, 0x00 }, LedStripRgbMode::NORMAL }
+};
+
+// Software clock for the schedule
+SoftRTC rtc;
+// Instance that drives the LEDs by the time of the day
+LightSchedule schedule(led_strip_rgb, led_strip_w, schedule_table,
+  array_length(schedule_table));
+// Instance that keeps the scenes in the EEPROM
+SceneStore scenes(led_strip_rgb, led_strip_w);
+// Instance that mixes the white and RGB LEDs for the color temperature mode
+CctWhite cct(led_strip_rgb, led_strip_w);
+// Instance that keeps the state of the lights across a reset
+Supervisor supervisor;
+// Instance that reads the analog inputs in turn without waiting
+AdcScheduler adc;
+#ifdef AUTO_BRIGHTNESS
+// Instance that scales the output with the ambient light
+AutoBrightness auto_brightness(AMBIENT_TARGET);
+#endif
+#ifdef MUSIC_INPUT
+// Instance that analyzes the audio input for the Music mode
+AudioAnalyzer audio_analyzer(pot_color_pin);
+#endif
+
+// Identifier of the mode button in the button events
+#define BTN_MODE 0
+// Index of the analog inputs in the ADC scheduler, in the order they are added
+#define ADC_POT 0
+#define ADC_LDR 1
+// Kelvin per step of the potentiometer in the color temperature mode
+#define CCT_PER_LEVEL 17
+// Lowest brightness that can be set in the color temperature mode
+#define CCT_MIN_BRIGHTNESS 8
+
+// The mode button is held down
+bool btn_mode_held = false;
+// The button was held down long enough to turn off the LEDs on its release
+bool btn_mode_long = false;
+// The potentiometer was used while the button was held down, the gesture of
+// the button is dropped
+bool btn_mode_used = false;
+
+// LEDs handled by the listeners of the button events
+struct Lights
+{
+  LedStrip &white;
+  LedStripRGB &rgb;
+  SceneStore &scenes;
+  LightSchedule &schedule;
+  SoftRTC &rtc;
+  CctWhite &cct;
+};
+
+Lights lights = { led_strip_w, led_strip_rgb, scenes, schedule, rtc, cct };
 
 /*
  * When the mode button is pressed depending on the condition of the led strip,
  * different mode changes are made.
  *  - If the white and RGB LEDs are all off, then turn on the white LEDs.
- *  - If the RGB LEDs are off and the white LEDs are on, then turn off the white
- *    LEDs and turn on the LEDs of colors (with the last mode that has been set).
- *  - When the RGB LEDs are on and they are in Fade mode (last mode in the list),
+ *  - If the RGB LEDs are off and the white LEDs are on, then mix them for the
+ *    color temperature mode, on the intensity of the white LEDs.
+ *  - In the color temperature mode, turn off the white LEDs and show the LEDs
+ *    of colors (with the last color and mode that have been set).
+ *  - When the RGB LEDs are on and they are in the last mode in the list,
  *    then turn off the RGB LEDs and turn on the white LEDs.
- *  - If the RGB LEDs are on and they are not in the Fade mode, then switch to
- *    the next mode in the list (NORMAL > STROBE > FLASH > FADE).
+ *  - If the RGB LEDs are on and they are not in the last mode, then switch to
+ *    the next mode in the list (NORMAL > STROBE > FLASH > FADE > CANDLE > FIRE
+ *    > TWINKLE > MUSIC).
  */
-void btnModeShortPressed(void)
+void btnModeShortPressed(Lights &lights)
 {
-  if(led_strip_w.getState() == LedStripState::OFF &&
-    led_strip_rgb.getState() == LedStripState::OFF)
+  if(lights.cct.isEnabled())
   {
-    led_strip_w.turnOn();
+    lights.cct.disable();
+    lights.white.turnOff();
+    lights.rgb.turnOn();
   }
-  else if(led_strip_rgb.getState() == LedStripState::OFF)
+  else if(lights.white.getState() == LedStripState::OFF &&
+    lights.rgb.getState() == LedStripState::OFF)
   {
-    led_strip_w.turnOff();
-    led_strip_rgb.turnOn();
+    lights.white.turnOn();
   }
-  else if(led_strip_rgb.getMode() == LedStripRgbMode::FADE)
+  else if(lights.rgb.getState() == LedStripState::OFF)
   {
-    led_strip_w.turnOn();
-    led_strip_rgb.nextMode();
-    led_strip_rgb.turnOff();
+    lights.cct.enable();
+  }
+  else if(lights.rgb.isLastMode())
+  {
+    lights.white.turnOn();
+    lights.rgb.nextMode();
+    lights.rgb.turnOff();
   }
   else
   {
-    led_strip_rgb.nextMode();
+    lights.rgb.nextMode();
   }
 }
 
@@ -115,14 +285,109 @@ void btnModeShortPressed(void)
  * When the mode button is pressed for approximately one second, then all the
  * LEDs are turned off.
  */
-void btnModeLongPressed(void)
+void btnModeLongPressed(Lights &lights)
 {
-  led_strip_w.turnOff();
-  led_strip_rgb.turnOff();
+  lights.cct.disable();
+  lights.white.turnOff();
+  lights.rgb.turnOff();
+}
+
+/*
+ * Consecutive clicks of the mode button handle the scenes and the schedule.
+ *  - Double click: recall the next saved scene.
+ *  - Triple click: save the current state as a new scene.
+ *  - Four clicks: enable or disable the schedule (once the clock is set).
+ *  - Five clicks: set the clock to CLOCK_SET_TIME and enable the schedule.
+ */
+void btnModeMultiClicked(Lights &lights, uint8_t clicks)
+{
+  switch (clicks) {
+    case 2:
+      lights.schedule.disable();
+      lights.cct.disable();
+      lights.scenes.recallNext();
+      break;
+    case 3:
+      lights.scenes.saveNext();
+      break;
+    case 4:
+      if(lights.schedule.isEnabled() || !lights.rtc.isSet())
+      {
+        lights.schedule.disable();
+        break;
+      }
+      lights.cct.disable();
+      lights.schedule.enable();
+      lights.schedule.apply(lights.rtc.getMinutes());
+      break;
+    case 5:
+      lights.rtc.setTime(CLOCK_SET_TIME);
+      lights.cct.disable();
+      lights.schedule.enable();
+      lights.schedule.apply(lights.rtc.getMinutes());
+      break;
+    default:
+      break;
+  }
+}
+
+/*
+ * Listener of the button events, the context are the lights. The long press
+ * acts on the release, so the button can be held down to change the
+ * brightness with the potentiometer, and a gesture that was used that way is
+ * dropped.
+ */
+void btnModeListener(void *context, BtnEvent event)
+{
+  Lights &lights = *static_cast<Lights*>(context);
+  if(event.button != BTN_MODE)
+  {
+    return;
+  }
+  switch (event.type) {
+    case BtnEventType::PRESS:
+      btn_mode_held = true;
+      break;
+    case BtnEventType::RELEASE:
+      btn_mode_held = false;
+      if(btn_mode_long)
+      {
+        btn_mode_long = false;
+        if(!btn_mode_used)
+        {
+          lights.schedule.disable();
+          btnModeLongPressed(lights);
+        }
+        btn_mode_used = false;
+      }
+      break;
+    case BtnEventType::CLICK:
+      if(btn_mode_used)
+      {
+        btn_mode_used = false;
+      }
+      else if(event.count == 1)
+      {
+        lights.schedule.disable();
+        btnModeShortPressed(lights);
+      }
+      else
+      {
+        btnModeMultiClicked(lights, event.count);
+      }
+      break;
+    case BtnEventType::LONG_PRESS:
+      btn_mode_long = true;
+      break;
+    default:
+      break;
+  }
 }
 
-// Instance to handle button press events.
-BtnHandler btn_mode(btn_mode_pin, btnModeShortPressed, btnModeLongPressed);
+// Queue of the button events, dispatched at the end of each loop.
+BtnEventBus btn_events;
+// Instance to debounce the buttons and generate their events.
+ButtonBank buttons(btn_events);
 
 // Function to calculate a color based on an input voltage.
 uint32_t color_mixer(uint16_t input_value)
@@ -161,50 +426,179 @@ uint32_t color_mixer(uint16_t input_value)
  * Function to read the voltage on the analog pin and based on the operating
  * mode perform an action.
  *  - When white LEDs are on, change the brightness of them.
- *  - When the RGB leds are turned on in Normal or Strobe mode, then change
- *  the color with the help of the color_mixer function.
+ *  - In the color temperature mode, change the temperature, or the brightness
+ *    while the mode button is held down.
+ *  - When the RGB leds are turned on in Normal, Strobe, Candle or Twinkle mode,
+ *  then change the color with the help of the color_mixer function.
  *  - If the RGB LEDs are on in Flash or Fade mode, then the speed of the color
  *    sequence is changed.
+ *  - When all the LEDs are off, the white LEDs are turned on only when the
+ *    value moves more than THRESHOLD_FOR_TURN_ON from the last one used.
  */
 void readPotValue(void)
 {
-  uint16_t new_pot_value = analogRead(pot_color_pin);
-  if((new_pot_value / 4) != last_pot_color_value)
+  pot_color_filtered = pot_color_filtered - (pot_color_filtered >> 2) +
+    adc.getValue(ADC_POT);
+  uint16_t new_pot_value = pot_color_filtered >> 2;
+  int16_t new_level = new_pot_value / 4;
+  if(new_level == last_pot_color_value)
+  {
+    return;
+  }
+  if(cct.isEnabled())
   {
-    last_pot_color_value = new_pot_value / 4;
-    if(led_strip_rgb.getState() == LedStripState::ON)
+    // The changes are relative, so the brightness and the temperature keep
+    // their values when the potentiometer switches from one to the other.
+    int16_t delta = new_level - (int16_t)last_pot_color_value;
+    last_pot_color_value = new_level;
+    if(btn_mode_held)
     {
-      LedStripRgbMode mode = led_strip_rgb.getMode();
-      switch (mode) {
-        case LedStripRgbMode::NORMAL:
-          led_strip_rgb.setColor(color_mixer(new_pot_value));
-          break;
-        case LedStripRgbMode::STROBE:
-          led_strip_rgb.setColor(color_mixer(new_pot_value));
-          break;
-        case LedStripRgbMode::FLASH:
-          led_strip_rgb.setSpeed(new_pot_value);
-          break;
-        case LedStripRgbMode::FADE:
-          led_strip_rgb.setSpeed(new_pot_value);
-          break;
-      }
+      btn_mode_used = true;
+      cct.setBrightness(constrain(cct.getBrightness() + delta, CCT_MIN_BRIGHTNESS, 255));
     }
-    else if(led_strip_w.getState() == LedStripState::ON)
+    else
     {
-      led_strip_w.setIntensity(last_pot_color_value);
+      cct.setTemperature(constrain((int16_t)cct.getTemperature() +
+        delta * CCT_PER_LEVEL, CCT_MIN, CCT_MAX));
     }
-    else
+    return;
+  }
+  if(led_strip_rgb.getState() == LedStripState::OFF &&
+    led_strip_w.getState() == LedStripState::OFF)
+  {
+    // Small variations of voltage must not turn on the light, the reference
+    // is kept until the potentiometer really moves.
+    if(abs(new_level - (int16_t)last_pot_color_value) <= THRESHOLD_FOR_TURN_ON)
     {
-      led_strip_w.setIntensity(last_pot_color_value);
-      led_strip_w.turnOn();
-      if(abs((new_pot_value / 4) - last_pot_color_value) > THRESHOLD_FOR_TURN_ON)
-      {
-        led_strip_w.setIntensity(last_pot_color_value);
-        led_strip_w.turnOn();
-      }
+      return;
     }
+    last_pot_color_value = new_level;
+    led_strip_w.setIntensity(last_pot_color_value);
+    led_strip_w.turnOn();
+    return;
   }
+  last_pot_color_value = new_level;
+  if(led_strip_rgb.getState() == LedStripState::ON)
+  {
+    LedStripRgbMode mode = led_strip_rgb.getMode();
+    switch (mode) {
+      case LedStripRgbMode::NORMAL:
+        led_strip_rgb.setColor(color_mixer(new_pot_value));
+        break;
+      case LedStripRgbMode::STROBE:
+      case LedStripRgbMode::CANDLE:
+      case LedStripRgbMode::TWINKLE:
+        led_strip_rgb.setColor(color_mixer(new_pot_value));
+        break;
+      case LedStripRgbMode::FLASH:
+        led_strip_rgb.setSpeed(new_pot_value);
+        break;
+      case LedStripRgbMode::FADE:
+        led_strip_rgb.setSpeed(new_pot_value);
+        break;
+      default:
+        break;
+    }
+  }
+  else
+  {
+    led_strip_w.setIntensity(last_pot_color_value);
+  }
+}
+
+/**
+ * Scales all the channels when the estimated current of the strip is over the
+ * budget of the supply. With the auto-brightness the lower of both scales is
+ * applied, and the loop does not integrate over the power limit.
+ */
+void limitPower(void)
+{
+  uint8_t scale = power_budget.update(led_strip_w.getDuty(),
+    led_strip_rgb.getOutputColor());
+#ifdef AUTO_BRIGHTNESS
+  auto_brightness.setLimit(scale);
+  scale = auto_brightness.getScale();
+#endif
+  led_strip_w.setOutputScale(scale);
+  led_strip_rgb.setOutputScale(scale);
+}
+
+/**
+ * State of the lights kept across a reset by the supervisor (29 bytes on the
+ * AVR, 32 with the padding of a 64 bits host).
+ */
+struct LightsSnapshot
+{
+  LedStripRGBSnapshot rgb;
+  LedStripSnapshot white;
+  uint16_t kelvin;
+  uint8_t cct_brightness;
+  bool cct;
+  bool schedule;
+  bool clock_set;
+  uint16_t minute;
+  uint16_t pot_level;
+  uint8_t ambient_scale;
+};
+
+static_assert(sizeof(LightsSnapshot) <= SUPERVISOR_SNAPSHOT_SIZE,
+  "The snapshot of the lights does not fit in the record of the supervisor");
+#if defined(__AVR__)
+static_assert(sizeof(LightsSnapshot) == 29, "The size of the snapshot of the lights changed");
+#endif
+
+/**
+ * Keeps the state of the lights for the next reset, it is called on every
+ * frame. The snapshot is written in place in the record of the supervisor.
+ */
+void saveLights(void)
+{
+  LightsSnapshot &snapshot = *static_cast<LightsSnapshot*>(supervisor.edit(sizeof(LightsSnapshot)));
+  snapshot.rgb = led_strip_rgb.getSnapshot();
+  // During the mix the RGB LEDs show the tint, the color to return to is kept
+  snapshot.rgb.color = cct.getRgbColor();
+  snapshot.rgb.mode = cct.getRgbMode();
+  snapshot.white = led_strip_w.getSnapshot();
+  snapshot.kelvin = cct.getTemperature();
+  snapshot.cct_brightness = cct.getBrightness();
+  snapshot.cct = cct.isEnabled();
+  snapshot.schedule = schedule.isEnabled();
+  snapshot.clock_set = rtc.isSet();
+  snapshot.minute = rtc.getMinutes();
+  snapshot.pot_level = last_pot_color_value;
+#ifdef AUTO_BRIGHTNESS
+  snapshot.ambient_scale = auto_brightness.getScale();
+#else
+  snapshot.ambient_scale = 255;
+#endif
+  supervisor.commit();
+}
+
+/**
+ * Resumes the state of the lights saved before the reset.
+ */
+void restoreLights(const LightsSnapshot &snapshot)
+{
+  led_strip_w.restoreSnapshot(snapshot.white);
+  led_strip_rgb.restoreSnapshot(snapshot.rgb);
+  cct.setTemperature(snapshot.kelvin);
+  cct.setBrightness(snapshot.cct_brightness);
+  if(snapshot.cct)
+  {
+    cct.enable();
+  }
+  if(snapshot.clock_set)
+  {
+    rtc.setTime(snapshot.minute);
+    if(snapshot.schedule)
+    {
+      schedule.enable();
+    }
+  }
+  last_pot_color_value = snapshot.pot_level;
+#ifdef AUTO_BRIGHTNESS
+  auto_brightness.setScale(snapshot.ambient_scale);
+#endif
 }
 
 /**
@@ -234,28 +628,129 @@ void test_leds(void)
  * Set the pins for the LEDs and the button. For the ATTiny85 it is not
  * necessary to configure the analog input. Executes the function to verify the
  * operation of the RGBW LEDs and establishes the initial status of the LEDs
- * (white on, RGB off).
+ * (white on, RGB off). When the state of the lights was kept across the reset
+ * it is resumed instead, without the test. The watchdog starts at the end, so
+ * the test does not trip it.
  */
 void setup() {
-  btn_mode.setup();
+  supervisor.begin();
+  LightsSnapshot snapshot;
+  bool resumed = supervisor.restore(&snapshot, sizeof(LightsSnapshot));
+  buttons.addButton(btn_mode_pin, BTN_MODE);
+  buttons.setup();
+  btn_events.subscribe(btnModeListener, &lights);
+  scenes.setCctWhite(&cct);
+  scenes.setup();
+#ifdef COMMON_ANODE
+  led_strip_w.setCommonAnodeEnable(true);
+  led_strip_rgb.setCommonAnodeEnable(true);
+#endif
   led_strip_w.setup();
   led_strip_rgb.setup();
+#ifdef BOARD_OUTPUT_ENGINE
+  led_output.begin();
+#endif
 
-  test_leds();
+  if(!resumed)
+  {
+    test_leds();
+  }
 
-  led_strip_w.turnOn();
-  led_strip_rgb.turnOff();
-  led_strip_rgb.setColor(default_color);
+  adc.addChannel(pot_color_pin);
+#ifdef AUTO_BRIGHTNESS
+  adc.addChannel(BOARD_LDR_PIN);
+#endif
+  pot_color_filtered = adc.getValue(ADC_POT) << 2;
+
+  led_strip_w.setRampTime(RAMP_TIME);
+  led_strip_w.setRampEase(LedRampEase::SMOOTH);
+  led_strip_rgb.setRampTime(RAMP_TIME);
+  // Same ease on both strips, so in the handoff one strip goes down with the
+  // same shape as the other goes up (the sum of the light still varies)
+  led_strip_rgb.setRampEase(LedRampEase::SMOOTH);
+  led_strip_rgb.setTransitionTime(TRANSITION_TIME);
+
+  power_budget.setChannel(PowerChannel::POWER_WHITE, CHANNEL_CURRENT, STRIP_LENGTH);
+  power_budget.setChannel(PowerChannel::POWER_RED, CHANNEL_CURRENT, STRIP_LENGTH);
+  power_budget.setChannel(PowerChannel::POWER_GREEN, CHANNEL_CURRENT, STRIP_LENGTH);
+  power_budget.setChannel(PowerChannel::POWER_BLUE, CHANNEL_CURRENT, STRIP_LENGTH);
+
+#ifdef MUSIC_INPUT
+  led_strip_rgb.setAudioAnalyzer(&audio_analyzer);
+#endif
+  if(resumed)
+  {
+    restoreLights(snapshot);
+  }
+  else
+  {
+    led_strip_w.turnOn();
+    led_strip_rgb.turnOff();
+    led_strip_rgb.setColor(default_color);
+  }
+
+  rtc.setWatchdogResetEnable(true);
+  rtc.begin();
 }
 
 /**
- * In each iteration the voltage value in the analog input is read,
- * the button input and the RGB LEDs are updated (mainly by the Strobe, Flash
- * and Fade modes, which vary their color in time).
+ * The buttons are scanned, the brightness ramp of the white LEDs advanced and
+ * the next analog input converted every BOARD_SCAN_DELAY milliseconds (the
+ * ADC is left to the audio analyzer while it runs). Every BOARD_FRAME_DELAY
+ * milliseconds the value of the potentiometer is used, the RGB LEDs are
+ * updated (mainly by the Strobe, Flash and Fade modes, which vary their color
+ * in time), the auto-brightness follows the light sensor while the LEDs are
+ * on and the power budget is applied. The schedule is evaluated
+ * when the minute of the clock changes, then the watchdog is fed and the state
+ * of the lights is kept for a reset. Between scans the CPU sleeps in idle
+ * mode. The button events are dispatched once the LEDs are updated.
  */
 void loop() {
-  readPotValue();
-  btn_mode.loop();
-  led_strip_rgb.loop();
-  delay(50);
+  buttons.scan();
+  led_strip_w.loop();
+#ifdef MUSIC_INPUT
+  if(audio_analyzer.isRunning())
+  {
+    adc.pause();
+  }
+  else
+  {
+    adc.poll();
+  }
+#else
+  adc.poll();
+#endif
+  if((millis() - last_frame_time) >= BOARD_FRAME_DELAY)
+  {
+    last_frame_time += BOARD_FRAME_DELAY;
+    if((millis() - last_frame_time) >= BOARD_FRAME_DELAY)
+    {
+      last_frame_time = millis();
+    }
+#ifdef MUSIC_INPUT
+    if(!audio_analyzer.isRunning())
+    {
+      readPotValue();
+    }
+#else
+    readPotValue();
+#endif
+    if(rtc.update())
+    {
+      schedule.apply(rtc.getMinutes());
+    }
+    led_strip_rgb.loop();
+#ifdef AUTO_BRIGHTNESS
+    if(led_strip_w.getState() == LedStripState::ON ||
+      led_strip_rgb.getState() == LedStripState::ON)
+    {
+      auto_brightness.update(adc.getValue(ADC_LDR), BOARD_FRAME_DELAY);
+    }
+#endif
+    limitPower();
+    rtc.feed();
+    saveLights();
+  }
+  btn_events.dispatch();
+  rtc.idle(BOARD_SCAN_DELAY);
 }
@@ -0,0 +1,153 @@
+/*
+ * Arduino.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Host version of the Arduino API used by the libraries and the sketch, for
+ * the native env of the tests. The time only moves with delay() or
+ * hostAdvance(), the outputs are kept in arrays that the tests can read and
+ * the analog and digital inputs are set by the tests.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "avr/pgmspace.h"
+
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+#ifndef F_CPU
+#define F_CPU 16500000UL
+#endif
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define HOST_PINS 32
+#define HOST_ANALOG_INPUTS 8
+
+#define _BV(bit) (1 << (bit))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define digitalPinToBitMask(pin) (1 << ((pin) & 0x07))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+/**
+ * State of the simulated board. write_hook is called after each write of a
+ * duty (analogWrite() or digitalWrite()), for example to record a timeline.
+ */
+struct HostBoard
+{
+  uint64_t micros;
+  uint8_t mode[HOST_PINS];
+  uint8_t level[HOST_PINS];
+  uint8_t duty[HOST_PINS];
+  uint8_t input[HOST_PINS];
+  uint16_t analog[HOST_ANALOG_INPUTS];
+  uint32_t writes;
+  void (*write_hook)(uint8_t pin, uint8_t duty);
+};
+
+inline HostBoard &hostBoard(void)
+{
+  static HostBoard board;
+  return board;
+}
+
+/**
+ * Leaves the board as after a power on, at time 0.
+ */
+inline void hostReset(void)
+{
+  memset(&hostBoard(), 0, sizeof(HostBoard));
+  for(uint8_t pin = 0; pin < HOST_PINS; pin++)
+  {
+    hostBoard().input[pin] = HIGH;
+  }
+}
+
+inline void hostAdvance(uint32_t micros)
+{
+  hostBoard().micros += micros;
+}
+
+// 32 bits like on the AVR, so they wrap in the same way
+inline uint32_t millis(void)
+{
+  return hostBoard().micros / 1000;
+}
+
+inline uint32_t micros(void)
+{
+  return hostBoard().micros;
+}
+
+inline void delay(unsigned long ms)
+{
+  hostAdvance(ms * 1000);
+}
+
+inline void delayMicroseconds(unsigned int us)
+{
+  hostAdvance(us);
+}
+
+inline void noInterrupts(void)
+{
+}
+
+inline void interrupts(void)
+{
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  hostBoard().mode[pin % HOST_PINS] = mode;
+}
+
+inline void hostWrite(uint8_t pin, uint8_t duty)
+{
+  HostBoard &board = hostBoard();
+  board.duty[pin % HOST_PINS] = duty;
+  board.level[pin % HOST_PINS] = duty >= 128 ? HIGH : LOW;
+  board.writes++;
+  if(board.write_hook != nullptr)
+  {
+    board.write_hook(pin, duty);
+  }
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+  hostWrite(pin, value ? 255 : 0);
+}
+
+inline void analogWrite(uint8_t pin, int value)
+{
+  hostWrite(pin, value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+/**
+ * Inputs read the level set by the tests in input[], high by default like a
+ * released button with pull-up.
+ */
+inline int digitalRead(uint8_t pin)
+{
+  return hostBoard().input[pin % HOST_PINS];
+}
+
+inline int analogRead(uint8_t channel)
+{
+  return hostBoard().analog[channel % HOST_ANALOG_INPUTS];
+}
+
+#endif /* HOST_ARDUINO_H_ */
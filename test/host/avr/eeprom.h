@@ -0,0 +1,71 @@
+/*
+ * eeprom.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Host version of the EEPROM access, 512 bytes that start erased (0xFF).
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef HOST_EEPROM_H_
+#define HOST_EEPROM_H_
+
+#define HOST_EEPROM_SIZE 512
+
+inline uint8_t *hostEeprom(void)
+{
+  static uint8_t eeprom[HOST_EEPROM_SIZE];
+  static bool erased = false;
+  if(!erased)
+  {
+    memset(eeprom, 0xFF, HOST_EEPROM_SIZE);
+    erased = true;
+  }
+  return eeprom;
+}
+
+inline uint8_t *hostEepromAddress(const void *address)
+{
+  return hostEeprom() + ((uintptr_t)address % HOST_EEPROM_SIZE);
+}
+
+inline uint8_t eeprom_read_byte(const uint8_t *address)
+{
+  return *hostEepromAddress(address);
+}
+
+inline uint16_t eeprom_read_word(const uint16_t *address)
+{
+  uint16_t value;
+  memcpy(&value, hostEepromAddress(address), sizeof(value));
+  return value;
+}
+
+inline void eeprom_read_block(void *destination, const void *source, size_t size)
+{
+  memcpy(destination, hostEepromAddress(source), size);
+}
+
+inline void eeprom_update_byte(uint8_t *address, uint8_t value)
+{
+  *hostEepromAddress(address) = value;
+}
+
+inline void eeprom_update_word(uint16_t *address, uint16_t value)
+{
+  memcpy(hostEepromAddress(address), &value, sizeof(value));
+}
+
+inline void eeprom_update_block(const void *source, void *destination, size_t size)
+{
+  memcpy(hostEepromAddress(destination), source, size);
+}
+
+#endif /* HOST_EEPROM_H_ */
@@ -0,0 +1,26 @@
+/*
+ * pgmspace.h
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Host version of the flash memory access, the tables are in the normal
+ * memory.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define memcpy_P memcpy
+
+#endif /* HOST_PGMSPACE_H_ */
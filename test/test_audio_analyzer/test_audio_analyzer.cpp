@@ -0,0 +1,323 @@
+/*
+ * test_audio_analyzer.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Bands and beats of AudioAnalyzer fed with synthetic signals and with the
+ * samples of a WAV file. Any 16 bits PCM WAV file can be analyzed with:
+ *   AUDIO_WAV=song.wav .pio/build/native/program
+ * it prints the levels and the beats every 50 ms.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+#include "AudioAnalyzer.h"
+
+// Rate of the free running ADC: 16.5 MHz / 128 / 13 cycles
+#define SAMPLE_RATE 9915
+
+static uint32_t beats;
+
+static void feed(AudioAnalyzer &analyzer, double sample)
+{
+  int16_t value = (int16_t)lround(sample);
+  analyzer.process(constrain(value, -512, 511));
+  if(analyzer.beatDetected())
+  {
+    beats++;
+  }
+}
+
+static void feedTone(AudioAnalyzer &analyzer, double frequency, double amplitude,
+  uint32_t duration)
+{
+  uint32_t samples = (uint32_t)SAMPLE_RATE * duration / 1000;
+  for(uint32_t i = 0; i < samples; i++)
+  {
+    feed(analyzer, amplitude * sin(2 * M_PI * frequency * i / SAMPLE_RATE));
+  }
+}
+
+/**
+ * Kick drum: a 60 Hz burst with an exponential decay on every beat.
+ */
+static void feedKicks(AudioAnalyzer &analyzer, uint16_t bpm, uint32_t duration)
+{
+  uint32_t samples = (uint32_t)SAMPLE_RATE * duration / 1000;
+  uint32_t period = (uint32_t)SAMPLE_RATE * 60 / bpm;
+  for(uint32_t i = 0; i < samples; i++)
+  {
+    double t = (double)(i % period) / SAMPLE_RATE;
+    feed(analyzer, 400 * exp(-t / 0.06) * sin(2 * M_PI * 60 * t));
+  }
+}
+
+static void writeLe(FILE *file, uint32_t value, uint8_t bytes)
+{
+  for(uint8_t i = 0; i < bytes; i++)
+  {
+    fputc((value >> (8 * i)) & 0xFF, file);
+  }
+}
+
+static uint32_t readLe(FILE *file, uint8_t bytes)
+{
+  uint32_t value = 0;
+  for(uint8_t i = 0; i < bytes; i++)
+  {
+    value |= (uint32_t)(fgetc(file) & 0xFF) << (8 * i);
+  }
+  return value;
+}
+
+/**
+ * Feeds a 16 bits PCM WAV file to the analyzer, the channels are mixed and
+ * resampled to the rate of the ADC, the full scale is the 10 bits of the ADC.
+ * @param report Prints the levels every 50 ms
+ * @return false if the file is not a 16 bits PCM WAV file
+ */
+static bool feedWav(AudioAnalyzer &analyzer, const char *path, bool report)
+{
+  FILE *file = fopen(path, "rb");
+  if(file == nullptr)
+  {
+    return false;
+  }
+  char id[5] = { 0 };
+  uint16_t channels = 0;
+  uint32_t rate = 0;
+  uint16_t bits = 0;
+  uint32_t data = 0;
+  if(fread(id, 1, 4, file) != 4 || strcmp(id, "RIFF") != 0)
+  {
+    fclose(file);
+    return false;
+  }
+  readLe(file, 4);
+  fread(id, 1, 4, file);
+  while(data == 0 && fread(id, 1, 4, file) == 4)
+  {
+    uint32_t size = readLe(file, 4);
+    if(strcmp(id, "fmt ") == 0)
+    {
+      uint16_t format = readLe(file, 2);
+      channels = readLe(file, 2);
+      rate = readLe(file, 4);
+      // Byte rate and block align
+      fseek(file, 6, SEEK_CUR);
+      bits = readLe(file, 2);
+      fseek(file, size - 16, SEEK_CUR);
+      if(format != 1 || bits != 16 || channels == 0)
+      {
+        fclose(file);
+        return false;
+      }
+    }
+    else if(strcmp(id, "data") == 0)
+    {
+      data = size;
+    }
+    else
+    {
+      fseek(file, size, SEEK_CUR);
+    }
+  }
+  if(rate == 0 || data == 0)
+  {
+    fclose(file);
+    return false;
+  }
+  uint32_t frames = data / (2 * channels);
+  uint32_t fed = 0;
+  for(uint32_t frame = 0; frame < frames; frame++)
+  {
+    int32_t mix = 0;
+    for(uint16_t c = 0; c < channels; c++)
+    {
+      mix += (int16_t)readLe(file, 2);
+    }
+    // Nearest sample at the rate of the ADC
+    while((uint64_t)fed * rate < (uint64_t)(frame + 1) * SAMPLE_RATE)
+    {
+      feed(analyzer, mix / channels / 64.0);
+      fed++;
+      if(report && fed % (SAMPLE_RATE / 20) == 0)
+      {
+        RGBColor levels = analyzer.getLevels();
+        printf("%7.2f s  bass %3u  mid %3u  high %3u  beats %u\n",
+          (double)fed / SAMPLE_RATE, levels.red, levels.green, levels.blue, beats);
+      }
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+void setUp(void)
+{
+  hostReset();
+  beats = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_silence_has_no_levels(void)
+{
+  AudioAnalyzer analyzer(0);
+  feedTone(analyzer, 0, 0, 1000);
+  RGBColor levels = analyzer.getLevels();
+  TEST_ASSERT_EQUAL(0, levels.red);
+  TEST_ASSERT_EQUAL(0, levels.green);
+  TEST_ASSERT_EQUAL(0, levels.blue);
+  TEST_ASSERT_EQUAL(0, beats);
+}
+
+void test_dc_offset_is_removed(void)
+{
+  AudioAnalyzer analyzer(0);
+  feedTone(analyzer, 0, 0, 10);
+  for(uint32_t i = 0; i < SAMPLE_RATE * 2; i++)
+  {
+    feed(analyzer, 100);
+  }
+  RGBColor levels = analyzer.getLevels();
+  TEST_ASSERT_LESS_OR_EQUAL(8, levels.red);
+  TEST_ASSERT_LESS_OR_EQUAL(8, levels.green);
+  TEST_ASSERT_LESS_OR_EQUAL(8, levels.blue);
+}
+
+/**
+ * A tone in the middle of each band gives the highest level to that band.
+ */
+void test_each_band_follows_its_tone(void)
+{
+  const double tones[3] = { 60, 700, 3500 };
+  for(uint8_t band = 0; band < 3; band++)
+  {
+    AudioAnalyzer analyzer(0);
+    feedTone(analyzer, tones[band], 200, 500);
+    RGBColor levels = analyzer.getLevels();
+    uint8_t level[3] = { levels.red, levels.green, levels.blue };
+    char message[48];
+    snprintf(message, sizeof(message), "%.0f Hz: %u %u %u", tones[band],
+      level[0], level[1], level[2]);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(32, level[band], message);
+    for(uint8_t other = 0; other < 3; other++)
+    {
+      if(other != band)
+      {
+        TEST_ASSERT_GREATER_THAN_MESSAGE(level[other], level[band], message);
+      }
+    }
+  }
+}
+
+void test_gain_scales_the_levels(void)
+{
+  AudioAnalyzer loud(0);
+  AudioAnalyzer sensitive(0);
+  sensitive.setGain(3);
+  feedTone(loud, 60, 100, 500);
+  feedTone(sensitive, 60, 100, 500);
+  TEST_ASSERT_INT_WITHIN(2, 2 * loud.getLevels().red, sensitive.getLevels().red);
+}
+
+void test_levels_decay_after_the_sound(void)
+{
+  AudioAnalyzer analyzer(0);
+  feedTone(analyzer, 60, 300, 500);
+  uint8_t level = analyzer.getLevels().red;
+  feedTone(analyzer, 0, 0, 100);
+  TEST_ASSERT_LESS_THAN(level / 2, analyzer.getLevels().red);
+  feedTone(analyzer, 0, 0, 1000);
+  TEST_ASSERT_EQUAL(0, analyzer.getLevels().red);
+}
+
+/**
+ * Each kick of a 120 BPM loop is a beat, after the average settles.
+ */
+void test_beats_follow_the_kicks(void)
+{
+  AudioAnalyzer analyzer(0);
+  feedKicks(analyzer, 120, 10000);
+  TEST_ASSERT_INT_WITHIN(2, 20, beats);
+}
+
+/**
+ * A constant bass is not a beat once the average follows it.
+ */
+void test_steady_bass_is_not_a_beat(void)
+{
+  AudioAnalyzer analyzer(0);
+  feedTone(analyzer, 60, 300, 2000);
+  beats = 0;
+  feedTone(analyzer, 60, 300, 5000);
+  TEST_ASSERT_EQUAL(0, beats);
+}
+
+/**
+ * The kicks written to a WAV file at 44.1 kHz give the same beats when the
+ * file is read back.
+ */
+void test_wav_file_is_analyzed(void)
+{
+  const char *path = "test_audio_analyzer.wav";
+  const uint32_t rate = 44100;
+  const uint32_t frames = rate * 5;
+  FILE *file = fopen(path, "wb");
+  TEST_ASSERT_TRUE(file != nullptr);
+  fputs("RIFF", file);
+  writeLe(file, 36 + frames * 4, 4);
+  fputs("WAVEfmt ", file);
+  writeLe(file, 16, 4);
+  writeLe(file, 1, 2);
+  writeLe(file, 2, 2);
+  writeLe(file, rate, 4);
+  writeLe(file, rate * 4, 4);
+  writeLe(file, 4, 2);
+  writeLe(file, 16, 2);
+  fputs("data", file);
+  writeLe(file, frames * 4, 4);
+  for(uint32_t i = 0; i < frames; i++)
+  {
+    double t = (double)(i % (rate / 2)) / rate;
+    int16_t sample = (int16_t)(25000 * exp(-t / 0.06) * sin(2 * M_PI * 60 * t));
+    writeLe(file, (uint16_t)sample, 2);
+    writeLe(file, (uint16_t)sample, 2);
+  }
+  fclose(file);
+
+  AudioAnalyzer analyzer(0);
+  TEST_ASSERT_TRUE(feedWav(analyzer, path, false));
+  remove(path);
+  TEST_ASSERT_INT_WITHIN(2, 10, beats);
+  TEST_ASSERT_FALSE(feedWav(analyzer, path, false));
+}
+
+int main(int argc, char **argv)
+{
+  const char *wav = getenv("AUDIO_WAV");
+  if(wav != nullptr)
+  {
+    AudioAnalyzer analyzer(0);
+    return feedWav(analyzer, wav, true) ? 0 : 1;
+  }
+  UNITY_BEGIN();
+  RUN_TEST(test_silence_has_no_levels);
+  RUN_TEST(test_dc_offset_is_removed);
+  RUN_TEST(test_each_band_follows_its_tone);
+  RUN_TEST(test_gain_scales_the_levels);
+  RUN_TEST(test_levels_decay_after_the_sound);
+  RUN_TEST(test_beats_follow_the_kicks);
+  RUN_TEST(test_steady_bass_is_not_a_beat);
+  RUN_TEST(test_wav_file_is_analyzed);
+  return UNITY_END();
+}
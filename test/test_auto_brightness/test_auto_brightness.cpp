@@ -0,0 +1,216 @@
+/*
+ * test_auto_brightness.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Loop of AutoBrightness on simulated light traces: the sensor sees the
+ * ambient light of the trace plus the light of the LEDs, proportional to the
+ * output scale, so the loop closes through the room like on the board.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "AutoBrightness.h"
+#include "Lfsr.h"
+
+#define LIGHT_TARGET 512
+// ADC counts of the light of the LEDs at full scale
+#define LIGHT_OF_LEDS 3
+
+/**
+ * Light of the trace at a time (ms), in ADC counts of the sensor.
+ */
+typedef uint16_t (*AmbientTrace)(uint32_t);
+
+static uint16_t dark(uint32_t time)
+{
+  return 0;
+}
+
+static uint16_t dim(uint32_t time)
+{
+  return 200;
+}
+
+static uint16_t daylight(uint32_t time)
+{
+  return 600;
+}
+
+/**
+ * A lamp switched on after 20 seconds.
+ */
+static uint16_t lamp(uint32_t time)
+{
+  return time < 20000 ? 50 : 350;
+}
+
+/**
+ * Sunrise: from dark to full daylight in a minute.
+ */
+static uint16_t sunrise(uint32_t time)
+{
+  return time < 60000 ? time * 900 / 60000 : 900;
+}
+
+/**
+ * A dim room with the noise of the sensor, +/- 15 counts.
+ */
+static uint16_t noisy(uint32_t time)
+{
+  static Lfsr lfsr;
+  return 200 + (lfsr.next() % 31) - 15;
+}
+
+static uint16_t sensor(AmbientTrace trace, uint32_t time, uint8_t scale)
+{
+  uint16_t light = trace(time) + LIGHT_OF_LEDS * scale;
+  return light > 1023 ? 1023 : light;
+}
+
+/**
+ * Runs the loop on a trace with frames of the given length and records the
+ * scale every 20 ms.
+ */
+static void run(AutoBrightness &loop, AmbientTrace trace, uint8_t frame, uint32_t length,
+  uint8_t *scales)
+{
+  for(uint32_t time = 0; time < length; time += frame)
+  {
+    loop.update(sensor(trace, time, loop.getScale()), frame);
+    if(scales != nullptr && (time + frame) % 20 == 0)
+    {
+      scales[(time + frame) / 20 - 1] = loop.getScale();
+    }
+  }
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * In a dark and a dim room the light settles within the band of the target
+ * in 15 seconds and the scale stops changing, lower in the dim room.
+ */
+void test_settles_on_the_target(void)
+{
+  const AmbientTrace traces[] = { dark, dim };
+  static uint8_t scales[1500];
+  uint8_t settled[2];
+  for(uint8_t t = 0; t < 2; t++)
+  {
+    AutoBrightness loop(LIGHT_TARGET);
+    run(loop, traces[t], 20, 30000, scales);
+    TEST_ASSERT_INT_WITHIN(AUTO_BRIGHTNESS_BAND_OUT, LIGHT_TARGET, loop.getLight());
+    for(uint16_t i = 750; i < 1500; i++)
+    {
+      TEST_ASSERT_EQUAL(scales[749], scales[i]);
+    }
+    settled[t] = loop.getScale();
+  }
+  TEST_ASSERT_LESS_THAN(settled[0], settled[1]);
+}
+
+/**
+ * A lamp switched on is followed without a jump: the scale changes at most
+ * by one every step and it goes down until the light is on the target again.
+ */
+void test_step_of_light_is_followed_slowly(void)
+{
+  static uint8_t scales[3000];
+  AutoBrightness loop(LIGHT_TARGET);
+  run(loop, lamp, 20, 60000, scales);
+  for(uint16_t i = 1; i < 3000; i++)
+  {
+    TEST_ASSERT_INT_WITHIN(1, scales[i - 1], scales[i]);
+  }
+  TEST_ASSERT_LESS_THAN(scales[999], scales[2999]);
+  TEST_ASSERT_INT_WITHIN(AUTO_BRIGHTNESS_BAND_OUT, LIGHT_TARGET, loop.getLight());
+}
+
+/**
+ * At sunrise the LEDs dim down to the lowest scale, they never go dark.
+ */
+void test_daylight_dims_to_the_minimum(void)
+{
+  static uint8_t scales[4500];
+  AutoBrightness loop(LIGHT_TARGET);
+  run(loop, sunrise, 20, 90000, scales);
+  TEST_ASSERT_EQUAL(AUTO_BRIGHTNESS_MIN, loop.getScale());
+  for(uint16_t i = 0; i < 4500; i++)
+  {
+    TEST_ASSERT_GREATER_OR_EQUAL(AUTO_BRIGHTNESS_MIN, scales[i]);
+  }
+}
+
+/**
+ * The noise of the sensor stays within the hysteresis, once settled the
+ * scale holds.
+ */
+void test_noise_does_not_flicker_the_leds(void)
+{
+  static uint8_t scales[2000];
+  AutoBrightness loop(LIGHT_TARGET);
+  run(loop, noisy, 20, 40000, scales);
+  uint8_t changes = 0;
+  for(uint16_t i = 1000; i < 2000; i++)
+  {
+    changes += scales[i] != scales[i - 1];
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(2, changes);
+}
+
+/**
+ * The loop steps with the time, not with the calls: the frames of 10 ms of
+ * the ATmega and of 20 ms of the Digispark give the same response.
+ */
+void test_response_does_not_depend_on_the_frame(void)
+{
+  static uint8_t fast[3000];
+  static uint8_t slow[3000];
+  AutoBrightness fast_loop(LIGHT_TARGET);
+  AutoBrightness slow_loop(LIGHT_TARGET);
+  run(fast_loop, lamp, 10, 60000, fast);
+  run(slow_loop, lamp, 20, 60000, slow);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(slow, fast, 3000);
+}
+
+/**
+ * The loop does not integrate over the limit of the power budget: when the
+ * light comes the scale goes down at once instead of unwinding first.
+ */
+void test_limit_does_not_wind_up(void)
+{
+  AutoBrightness loop(LIGHT_TARGET);
+  loop.setLimit(100);
+  run(loop, dark, 20, 30000, nullptr);
+  TEST_ASSERT_EQUAL(100, loop.getScale());
+  uint32_t time = 0;
+  while(loop.getScale() >= 100 && time < 5000)
+  {
+    loop.update(sensor(daylight, time, loop.getScale()), 20);
+    time += 20;
+  }
+  TEST_ASSERT_LESS_THAN(5000, time);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_settles_on_the_target);
+  RUN_TEST(test_step_of_light_is_followed_slowly);
+  RUN_TEST(test_daylight_dims_to_the_minimum);
+  RUN_TEST(test_noise_does_not_flicker_the_leds);
+  RUN_TEST(test_response_does_not_depend_on_the_frame);
+  RUN_TEST(test_limit_does_not_wind_up);
+  return UNITY_END();
+}
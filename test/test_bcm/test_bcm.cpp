@@ -0,0 +1,140 @@
+/*
+ * test_bcm.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Bit planes of BcmOutput on a port in memory: the interruption is called by
+ * hand, so the mask of each plane can be read from the port. The duties of
+ * a color are written to the planes once, on the commit of the strip.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "BcmOutput.h"
+#include "LedStripRGB.h"
+#include "LedStrip.h"
+
+static volatile uint8_t port;
+static volatile uint8_t ddr;
+
+/**
+ * Runs a whole period and keeps the mask of each plane.
+ */
+static void period(BcmOutput &bcm, uint8_t *masks)
+{
+  for(uint8_t plane = 0; plane < BCM_PLANES; plane++)
+  {
+    bcm.nextPlane();
+    masks[plane] = port;
+  }
+}
+
+/**
+ * Mask of each plane for the duties of the channels 0 to count - 1.
+ */
+static void expectPlanes(const uint8_t *masks, const uint8_t *duties, uint8_t count)
+{
+  for(uint8_t plane = 0; plane < BCM_PLANES; plane++)
+  {
+    uint8_t expected = 0;
+    for(uint8_t channel = 0; channel < count; channel++)
+    {
+      if(duties[channel] & (1 << plane))
+      {
+        expected |= 1 << channel;
+      }
+    }
+    TEST_ASSERT_EQUAL_HEX8(expected, masks[plane]);
+  }
+}
+
+void setUp(void)
+{
+  hostReset();
+  port = 0;
+  ddr = 0;
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * The writes are kept until the commit, then the planes of all the channels
+ * are swapped in at the start of the next period.
+ */
+void test_writes_are_applied_on_commit(void)
+{
+  BcmOutput bcm(&port, &ddr);
+  uint8_t masks[BCM_PLANES];
+  const uint8_t first[] = { 0x81, 0x3C, 0xFF };
+  const uint8_t second[] = { 0x10, 0x00, 0x7E };
+  const uint8_t off[] = { 0, 0, 0 };
+  for(uint8_t channel = 0; channel < 3; channel++)
+  {
+    bcm.setup(channel);
+  }
+  TEST_ASSERT_EQUAL_HEX8(0x07, ddr);
+  for(uint8_t channel = 0; channel < 3; channel++)
+  {
+    bcm.write(channel, first[channel]);
+  }
+  period(bcm, masks);
+  expectPlanes(masks, off, 3);
+  bcm.commit();
+  period(bcm, masks);
+  expectPlanes(masks, first, 3);
+
+  for(uint8_t channel = 0; channel < 3; channel++)
+  {
+    bcm.write(channel, second[channel]);
+  }
+  period(bcm, masks);
+  expectPlanes(masks, first, 3);
+  bcm.commit();
+  period(bcm, masks);
+  expectPlanes(masks, second, 3);
+}
+
+/**
+ * The strips commit after the channels of a color, the RGB color and the
+ * white duty reach the planes without another call.
+ */
+void test_strips_commit_their_colors(void)
+{
+  BcmOutput bcm(&port, &ddr);
+  LedStripRGB rgb({ 0, 1, 2 }, bcm);
+  LedStrip white(3, bcm);
+  uint8_t masks[BCM_PLANES];
+  rgb.setup();
+  white.setup();
+  const uint8_t duties[] = { 0x2A, 0x55, 0xC3, 0x99 };
+  const uint8_t off[] = { 0, 0, 0, 0 };
+  rgb.setColor(0x2A55C3);
+  rgb.turnOn();
+  rgb.loop();
+  period(bcm, masks);
+  expectPlanes(masks, duties, 3);
+  white.setIntensity(0x99);
+  white.turnOn();
+  period(bcm, masks);
+  expectPlanes(masks, duties, 4);
+  rgb.turnOff();
+  white.turnOff();
+  rgb.loop();
+  white.loop();
+  period(bcm, masks);
+  expectPlanes(masks, off, 4);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_writes_are_applied_on_commit);
+  RUN_TEST(test_strips_commit_their_colors);
+  return UNITY_END();
+}
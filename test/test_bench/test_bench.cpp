@@ -0,0 +1,246 @@
+/*
+ * test_bench.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Cycle benchmarks of the hot paths, run on the ATmega328P of simavr
+ * (pio test -e simavr). The cycles are counted by Timer1 running at F_CPU,
+ * so they are the same on a real board at the same clock. The results are
+ * printed as messages of the tests and each test fails when its budget is
+ * exceeded.
+ *
+ * The load of the output engines is measured in the envs that select them
+ * (simavr-softpwm and simavr-bcm): a busy loop counts its iterations with and
+ * without the interruptions of Timer1, for several numbers of channels.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "LedStripPixels.h"
+#include "LedStripRGB.h"
+#include "PixelEffects.h"
+#include "BoardOutput.h"
+
+// Pixels of the segment of the benchmarks
+#define BENCH_PIXELS 60
+// Gap between two pixels that is far below the reset time of the strips
+// (50 us on the first WS2812), the budget of the computation of a pixel
+#define BENCH_PIXEL_BUDGET 400
+// Cycles of a frame of LedStripRGB, 0.5 ms of the 10 ms frame of the ATmega
+#define BENCH_FRAME_BUDGET 8000
+// Frames measured for each case of the compositor
+#define BENCH_FRAMES 64
+// Milliseconds of each busy loop of the load of the engines
+#define BENCH_LOAD_TIME 250
+// Share of the CPU that the engine may take, per mille
+#define BENCH_LOAD_BUDGET 50
+
+static uint16_t cycles_overhead = 0;
+
+static inline void startCycles(void)
+{
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  TCCR1B = _BV(CS10);
+}
+
+/**
+ * Cycles since startCycles(), up to 65535.
+ */
+static inline uint16_t stopCycles(void)
+{
+  uint16_t cycles = TCNT1;
+  TCCR1B = 0;
+  return cycles - cycles_overhead;
+}
+
+static void report(const char *name, uint32_t value, const char *unit)
+{
+  char message[64];
+  snprintf(message, sizeof(message), "%s: %lu %s", name, (unsigned long)value, unit);
+  TEST_MESSAGE(message);
+}
+
+/**
+ * Average cycles of an effect per pixel along a segment, over 16 frames.
+ */
+static uint16_t effectCycles(PixelEffect effect, PixelEffectContext &context)
+{
+  uint32_t total = 0;
+  volatile uint32_t sink;
+  for(uint16_t frame = 0; frame < 16; frame++)
+  {
+    uint8_t sreg = SREG;
+    cli();
+    startCycles();
+    for(uint16_t index = 0; index < BENCH_PIXELS; index++)
+    {
+      sink = effect(&context, index, frame);
+    }
+    total += stopCycles();
+    SREG = sreg;
+  }
+  (void)sink;
+  return total / (16UL * BENCH_PIXELS);
+}
+
+/**
+ * Average cycles of loop() of a strip over BENCH_FRAMES frames, one frame
+ * every BOARD_FRAME_DELAY as in the sketch.
+ */
+static uint16_t frameCycles(LedStripRGB &strip)
+{
+  uint32_t total = 0;
+  for(uint8_t frame = 0; frame < BENCH_FRAMES; frame++)
+  {
+    delay(BOARD_FRAME_DELAY);
+    uint8_t sreg = SREG;
+    cli();
+    startCycles();
+    strip.loop();
+    total += stopCycles();
+    SREG = sreg;
+  }
+  return total / BENCH_FRAMES;
+}
+
+/**
+ * Iterations of a busy loop during the given time, the time is counted by
+ * Timer0 (millis) so Timer1 is free for the engines.
+ */
+static uint32_t busyLoops(uint16_t time)
+{
+  uint32_t loops = 0;
+  uint32_t start = millis();
+  while(millis() - start < time)
+  {
+    loops++;
+  }
+  return loops;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_pixel_effects(void)
+{
+  const PixelEffect effects[] = { pixelRainbow, pixelChase, pixelTwinkle, pixelGradient };
+  const char *names[] = { "rainbow", "chase", "twinkle", "gradient" };
+  for(uint8_t i = 0; i < 4; i++)
+  {
+    PixelEffectContext context;
+    uint16_t cycles = effectCycles(effects[i], context);
+    report(names[i], cycles, "cycles/pixel");
+    TEST_ASSERT_LESS_OR_EQUAL(BENCH_PIXEL_BUDGET, cycles);
+  }
+}
+
+/**
+ * Whole frames sent by LedStripPixels, the 480 cycles of the 24 bits plus the
+ * computation of the pixel and the gap between pixels.
+ */
+void test_pixel_frames(void)
+{
+  const PixelEffect effects[] = { pixelRainbow, pixelTwinkle };
+  const char *names[] = { "frame rainbow", "frame twinkle" };
+  for(uint8_t i = 0; i < 2; i++)
+  {
+    PixelEffectContext context;
+    LedStripPixels strip(8);
+    strip.setup();
+    uint8_t segment = strip.addSegment(BENCH_PIXELS, LedStripRgbMode::NORMAL, COLOR_WHITE);
+    strip.setSegmentEffect(segment, effects[i], &context);
+    strip.turnOn();
+    strip.show();
+    report(names[i], strip.getPixelCycles(), "cycles/pixel");
+    TEST_ASSERT_LESS_OR_EQUAL(480 + BENCH_PIXEL_BUDGET, strip.getPixelCycles());
+  }
+}
+
+/**
+ * Frames of LedStripRGB with and without the overlay layers, the cost of
+ * the compositor is the difference.
+ */
+void test_compositor_frames(void)
+{
+  const LedStripRgbMode modes[] = { LedStripRgbMode::NORMAL, LedStripRgbMode::FADE };
+  const char *names[] = { "frame normal", "frame fade" };
+  for(uint8_t i = 0; i < 2; i++)
+  {
+    LedStripRGB strip({ 9, 10, 11 });
+    strip.setup();
+    strip.setColor(COLOR_DARKPURPLE);
+    strip.setMode(modes[i]);
+    strip.turnOn();
+    uint16_t base = frameCycles(strip);
+    strip.setOverlay(0, LedOverlayMode::OVERLAY_MODULATE, 2000, 128);
+    strip.setOverlay(1, LedOverlayMode::OVERLAY_FLASH, 500, 200, COLOR_WHITE);
+    uint16_t layered = frameCycles(strip);
+    char name[32];
+    report(names[i], base, "cycles");
+    snprintf(name, sizeof(name), "%s + 2 overlays", names[i]);
+    report(name, layered, "cycles");
+    snprintf(name, sizeof(name), "compositor on %s", names[i] + 6);
+    report(name, layered > base ? layered - base : 0, "cycles");
+    TEST_ASSERT_LESS_OR_EQUAL(BENCH_FRAME_BUDGET, layered);
+  }
+}
+
+/**
+ * Share of the CPU taken by the interruptions of the engine of the profile,
+ * with distinct duties so SoftPwm has one edge per channel.
+ */
+void test_engine_load(void)
+{
+#ifdef BOARD_OUTPUT_ENGINE
+  const uint8_t channels[] = { 1, 3, 6 };
+  uint32_t idle = busyLoops(BENCH_LOAD_TIME);
+  report("idle", idle, "loops");
+  for(uint8_t i = 0; i < 3; i++)
+  {
+    BoardOutput engine(&BOARD_LED_PORT, &BOARD_LED_DDR);
+    for(uint8_t channel = 0; channel < channels[i]; channel++)
+    {
+      engine.setup(channel);
+      engine.write(channel, 17 + channel * 41);
+    }
+    engine.commit();
+    engine.begin();
+    uint32_t busy = busyLoops(BENCH_LOAD_TIME);
+    engine.end();
+    uint16_t load = busy < idle ? 1000 - busy * 1000 / idle : 0;
+    char name[24];
+    snprintf(name, sizeof(name), "load %u channels", channels[i]);
+    report(name, load, "per mille");
+    TEST_ASSERT_LESS_OR_EQUAL(BENCH_LOAD_BUDGET, load);
+  }
+#else
+  TEST_IGNORE_MESSAGE("no output engine in this env");
+#endif
+}
+
+void setup(void)
+{
+  startCycles();
+  cycles_overhead = stopCycles();
+  UNITY_BEGIN();
+  RUN_TEST(test_pixel_effects);
+  RUN_TEST(test_pixel_frames);
+  RUN_TEST(test_compositor_frames);
+  RUN_TEST(test_engine_load);
+  UNITY_END();
+}
+
+void loop(void)
+{
+}
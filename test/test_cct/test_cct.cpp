@@ -0,0 +1,185 @@
+/*
+ * test_cct.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Color temperature mode of CctWhite: the mix only borrows the LEDs, the
+ * intensity of the white LEDs and the color and mode of the RGB LEDs are
+ * the same before and after it, however many times it is entered.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "CctWhite.h"
+#include "RGBColors.h"
+
+#define WHITE_PIN 4
+
+/**
+ * Runs the loops for a second, the mix scale of the white slews to its
+ * target.
+ */
+static void settle(LedStripRGB &rgb, LedStrip &white)
+{
+  for(uint8_t frame = 0; frame < 100; frame++)
+  {
+    delay(10);
+    white.loop();
+    rgb.loop();
+  }
+}
+
+void setUp(void)
+{
+  hostReset();
+}
+
+void tearDown(void)
+{
+}
+
+void test_disable_restores_the_color_and_the_mode(void)
+{
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(WHITE_PIN);
+  CctWhite cct(rgb, white);
+  rgb.setColor(COLOR_DARKPURPLE);
+  rgb.setMode(LedStripRgbMode::FADE);
+  white.turnOn();
+  cct.enable();
+  TEST_ASSERT_EQUAL(LedStripRgbMode::NORMAL, rgb.getMode());
+  TEST_ASSERT_NOT_EQUAL(COLOR_DARKPURPLE, rgb.getColor());
+  TEST_ASSERT_EQUAL_HEX32(COLOR_DARKPURPLE, cct.getRgbColor());
+  TEST_ASSERT_EQUAL(LedStripRgbMode::FADE, cct.getRgbMode());
+  cct.disable();
+  TEST_ASSERT_EQUAL_HEX32(COLOR_DARKPURPLE, rgb.getColor());
+  TEST_ASSERT_EQUAL(LedStripRgbMode::FADE, rgb.getMode());
+}
+
+/**
+ * The mix takes a part of the white with the mix scale, the intensity set
+ * by the user is not changed and the whole duty comes back.
+ */
+void test_white_keeps_its_intensity(void)
+{
+  HostBoard &board = hostBoard();
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(WHITE_PIN);
+  CctWhite cct(rgb, white);
+  white.setIntensity(200);
+  white.turnOn();
+  TEST_ASSERT_EQUAL(200, board.duty[WHITE_PIN]);
+  cct.enable();
+  settle(rgb, white);
+  TEST_ASSERT_EQUAL(200, white.getIntensity());
+  TEST_ASSERT_LESS_THAN(200, board.duty[WHITE_PIN]);
+  cct.disable();
+  settle(rgb, white);
+  TEST_ASSERT_EQUAL(200, white.getIntensity());
+  TEST_ASSERT_EQUAL(200, board.duty[WHITE_PIN]);
+}
+
+/**
+ * Entering and leaving the mode again and again does not dim the LEDs, the
+ * brightness of the mix is its own.
+ */
+void test_cycles_do_not_dim_the_white(void)
+{
+  HostBoard &board = hostBoard();
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(WHITE_PIN);
+  CctWhite cct(rgb, white);
+  white.setIntensity(180);
+  white.turnOn();
+  cct.enable();
+  settle(rgb, white);
+  uint8_t mixed = board.duty[WHITE_PIN];
+  uint32_t tint = rgb.getColor();
+  for(uint8_t cycle = 0; cycle < 5; cycle++)
+  {
+    cct.disable();
+    settle(rgb, white);
+    TEST_ASSERT_EQUAL(180, board.duty[WHITE_PIN]);
+    cct.enable();
+    settle(rgb, white);
+    TEST_ASSERT_EQUAL(mixed, board.duty[WHITE_PIN]);
+    TEST_ASSERT_EQUAL_HEX32(tint, rgb.getColor());
+  }
+  TEST_ASSERT_EQUAL(255, cct.getBrightness());
+}
+
+/**
+ * The white slews to the mix, without a step that can be seen.
+ */
+void test_white_slews_to_the_mix(void)
+{
+  HostBoard &board = hostBoard();
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(WHITE_PIN);
+  CctWhite cct(rgb, white);
+  white.turnOn();
+  cct.enable();
+  uint8_t last = board.duty[WHITE_PIN];
+  TEST_ASSERT_EQUAL(255, last);
+  for(uint8_t frame = 0; frame < 100; frame++)
+  {
+    delay(10);
+    white.loop();
+    TEST_ASSERT_LESS_OR_EQUAL(last, board.duty[WHITE_PIN]);
+    TEST_ASSERT_LESS_OR_EQUAL(4, last - board.duty[WHITE_PIN]);
+    last = board.duty[WHITE_PIN];
+  }
+  TEST_ASSERT_LESS_THAN(128, last);
+}
+
+/**
+ * The brightness scales the white and the tint together, so the temperature
+ * does not change with it.
+ */
+void test_brightness_scales_the_whole_mix(void)
+{
+  HostBoard &board = hostBoard();
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(WHITE_PIN);
+  CctWhite cct(rgb, white);
+  white.turnOn();
+  cct.setTemperature(3000);
+  cct.enable();
+  settle(rgb, white);
+  uint8_t full_white = board.duty[WHITE_PIN];
+  uint8_t full_red = rgb.getColor() >> 16;
+  cct.setBrightness(128);
+  settle(rgb, white);
+  TEST_ASSERT_INT_WITHIN(1, full_white / 2, board.duty[WHITE_PIN]);
+  TEST_ASSERT_INT_WITHIN(1, full_red / 2, rgb.getColor() >> 16);
+  TEST_ASSERT_EQUAL(255, white.getIntensity());
+}
+
+void test_disable_without_enable_keeps_the_leds(void)
+{
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(WHITE_PIN);
+  CctWhite cct(rgb, white);
+  rgb.setColor(COLOR_DARKPURPLE);
+  rgb.setMode(LedStripRgbMode::STROBE);
+  cct.disable();
+  TEST_ASSERT_EQUAL_HEX32(COLOR_DARKPURPLE, rgb.getColor());
+  TEST_ASSERT_EQUAL(LedStripRgbMode::STROBE, rgb.getMode());
+  TEST_ASSERT_EQUAL_HEX32(COLOR_DARKPURPLE, cct.getRgbColor());
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_disable_restores_the_color_and_the_mode);
+  RUN_TEST(test_white_keeps_its_intensity);
+  RUN_TEST(test_cycles_do_not_dim_the_white);
+  RUN_TEST(test_white_slews_to_the_mix);
+  RUN_TEST(test_brightness_scales_the_whole_mix);
+  RUN_TEST(test_disable_without_enable_keeps_the_leds);
+  return UNITY_END();
+}
@@ -0,0 +1,443 @@
+/*
+ * test_flicker.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Flicker analyzer of the duty timeline written by the simulated board. For
+ * each mode of LedStripRGB it measures:
+ *  - the flicker index (area of the light over its mean / total area),
+ *  - the largest step between two writes in perceptual lightness (CIE L*,
+ *    0 - 100), the duty of the PWM is linear light,
+ *  - the intervals between the updates of the LEDs (frame rate and jitter),
+ *    as a histogram.
+ * The metrics are printed as a table and each timeline is plotted as an SVG
+ * file in output/, with the histogram of the intervals. The timeline of a
+ * replay (the CSV files of test_replay/output) can be analyzed with:
+ *   FLICKER_CSV=test/test_replay/output/modes.csv .pio/build/native/program
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unity.h>
+#include "LedStripRGB.h"
+#include "LedStrip.h"
+
+#define TIMELINE_SIZE 20000
+#define CHANNELS 5
+// Buckets of the histogram of the intervals, 5 ms each
+#define HISTOGRAM_BUCKETS 12
+#define HISTOGRAM_WIDTH 5
+#define PLOT_PATH 160
+
+/**
+ * A write of a duty to a pin.
+ */
+struct TimelineEvent
+{
+  uint32_t time;
+  uint8_t pin;
+  uint8_t duty;
+};
+
+struct FlickerMetrics
+{
+  double flicker_index;
+  double percent_flicker;
+  double max_step;
+  uint32_t updates;
+  double mean_interval;
+  uint32_t min_interval;
+  uint32_t max_interval;
+  uint32_t histogram[HISTOGRAM_BUCKETS];
+};
+
+static TimelineEvent timeline[TIMELINE_SIZE];
+static uint16_t timeline_length = 0;
+static uint8_t timeline_duty[HOST_PINS];
+
+static void recordWrite(uint8_t pin, uint8_t duty)
+{
+  pin %= HOST_PINS;
+  if(timeline_duty[pin] == duty || timeline_length >= TIMELINE_SIZE)
+  {
+    return;
+  }
+  timeline_duty[pin] = duty;
+  timeline[timeline_length++] = { millis(), pin, duty };
+}
+
+/**
+ * CIE lightness of a duty, 0 - 100.
+ */
+static double lightness(uint8_t duty)
+{
+  double y = duty / 255.0;
+  return y > 0.008856 ? 116 * cbrt(y) - 16 : 903.3 * y;
+}
+
+/**
+ * Metrics of the pins of the mask between two times, the light is the sum of
+ * the duties of the pins.
+ */
+static FlickerMetrics analyze(uint32_t mask, uint32_t start, uint32_t end)
+{
+  FlickerMetrics metrics;
+  memset(&metrics, 0, sizeof(metrics));
+  uint8_t duty[HOST_PINS];
+  memset(duty, 0, sizeof(duty));
+  uint16_t first = 0;
+  for(; first < timeline_length && timeline[first].time < start; first++)
+  {
+    duty[timeline[first].pin] = timeline[first].duty;
+  }
+
+  // Light as a step function, integrated in 1 ms slots
+  double total = 0;
+  double minimum = 1e9;
+  double maximum = 0;
+  uint32_t length = end - start;
+  double *light = new double[length];
+  uint16_t index = first;
+  uint32_t first_update = 0;
+  uint32_t last_update = 0;
+  metrics.min_interval = 0xFFFFFFFF;
+  for(uint32_t t = start; t < end; t++)
+  {
+    bool updated = false;
+    while(index < timeline_length && timeline[index].time <= t)
+    {
+      const TimelineEvent &event = timeline[index++];
+      if(((mask >> event.pin) & 1) == 0)
+      {
+        continue;
+      }
+      double step = fabs(lightness(event.duty) - lightness(duty[event.pin]));
+      metrics.max_step = fmax(metrics.max_step, step);
+      duty[event.pin] = event.duty;
+      updated = true;
+    }
+    if(updated)
+    {
+      if(metrics.updates == 0)
+      {
+        first_update = t;
+      }
+      else
+      {
+        uint32_t interval = t - last_update;
+        metrics.min_interval = interval < metrics.min_interval ? interval : metrics.min_interval;
+        metrics.max_interval = interval > metrics.max_interval ? interval : metrics.max_interval;
+        uint8_t bucket = interval / HISTOGRAM_WIDTH;
+        metrics.histogram[bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1]++;
+      }
+      metrics.updates++;
+      last_update = t;
+    }
+    double sum = 0;
+    for(uint8_t pin = 0; pin < HOST_PINS; pin++)
+    {
+      if((mask >> pin) & 1)
+      {
+        sum += duty[pin];
+      }
+    }
+    light[t - start] = sum;
+    total += sum;
+    minimum = fmin(minimum, sum);
+    maximum = fmax(maximum, sum);
+  }
+  double mean = total / length;
+  double above = 0;
+  for(uint32_t i = 0; i < length; i++)
+  {
+    above += light[i] > mean ? light[i] - mean : 0;
+  }
+  delete[] light;
+  metrics.flicker_index = total > 0 ? above / total : 0;
+  metrics.percent_flicker = maximum + minimum > 0 ? (maximum - minimum) / (maximum + minimum) : 0;
+  if(metrics.updates > 1)
+  {
+    metrics.mean_interval = (double)(last_update - first_update) / (metrics.updates - 1);
+  }
+  else
+  {
+    metrics.min_interval = 0;
+  }
+  return metrics;
+}
+
+static void printMetrics(const char *name, const FlickerMetrics &metrics)
+{
+  printf("%-18s FI %.3f  PF %3.0f%%  dL* %5.1f  %4u updates  %5.1f ms (%u - %u)  |",
+    name, metrics.flicker_index, metrics.percent_flicker * 100, metrics.max_step,
+    (unsigned)metrics.updates, metrics.mean_interval, (unsigned)metrics.min_interval,
+    (unsigned)metrics.max_interval);
+  for(uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+  {
+    printf(" %u", (unsigned)metrics.histogram[i]);
+  }
+  printf("\n");
+}
+
+/**
+ * Plots the duties of the pins of the mask between two times and the
+ * histogram of the intervals as an SVG file.
+ */
+static void plot(const char *path, uint32_t mask, uint32_t start, uint32_t end,
+  const FlickerMetrics &metrics)
+{
+  const char *colors[] = { "red", "green", "#888", "blue", "orange" };
+  const uint16_t width = 800;
+  FILE *svg = fopen(path, "w");
+  if(svg == nullptr)
+  {
+    return;
+  }
+  fprintf(svg, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%u\" height=\"420\">\n", width + 20);
+  fprintf(svg, "<rect x=\"10\" y=\"10\" width=\"%u\" height=\"256\" fill=\"none\" stroke=\"#ccc\"/>\n", width);
+  for(uint8_t pin = 0; pin < HOST_PINS; pin++)
+  {
+    if(((mask >> pin) & 1) == 0)
+    {
+      continue;
+    }
+    fprintf(svg, "<polyline fill=\"none\" stroke=\"%s\" points=\"", colors[pin % CHANNELS]);
+    uint8_t duty = 0;
+    for(uint16_t i = 0; i < timeline_length; i++)
+    {
+      const TimelineEvent &event = timeline[i];
+      if(event.pin != pin || event.time >= end)
+      {
+        continue;
+      }
+      uint32_t time = event.time < start ? start : event.time;
+      double x = 10 + (double)(time - start) * width / (end - start);
+      fprintf(svg, "%.1f,%u %.1f,%u ", x, 265 - duty, x, 265 - event.duty);
+      duty = event.duty;
+    }
+    fprintf(svg, "%u,%u\"/>\n", 10 + width, 265 - duty);
+  }
+  uint32_t highest = 1;
+  for(uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+  {
+    highest = metrics.histogram[i] > highest ? metrics.histogram[i] : highest;
+  }
+  for(uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+  {
+    uint32_t height = metrics.histogram[i] * 100 / highest;
+    fprintf(svg, "<rect x=\"%u\" y=\"%u\" width=\"50\" height=\"%u\" fill=\"steelblue\"/>\n",
+      10 + i * 60, 390 - (unsigned)height, (unsigned)height);
+    fprintf(svg, "<text x=\"%u\" y=\"410\" font-size=\"11\">%u ms</text>\n",
+      10 + i * 60, i * HISTOGRAM_WIDTH);
+  }
+  fprintf(svg, "<text x=\"10\" y=\"282\" font-size=\"12\">FI %.3f, max dL* %.1f, "
+    "%.1f ms between updates</text>\n", metrics.flicker_index, metrics.max_step,
+    metrics.mean_interval);
+  fprintf(svg, "</svg>\n");
+  fclose(svg);
+}
+
+static void plotPath(char *path, const char *name)
+{
+  char folder[PLOT_PATH - 32];
+  strncpy(folder, __FILE__, sizeof(folder) - 1);
+  folder[sizeof(folder) - 1] = '\0';
+  char *slash = strrchr(folder, '/');
+  strcpy(slash != nullptr ? slash : folder, slash != nullptr ? "/output" : "output");
+  mkdir(folder, 0755);
+  snprintf(path, PLOT_PATH, "%s/%s.svg", folder, name);
+}
+
+/**
+ * Runs a RGB strip in a mode for the given time with the scheduling of the
+ * main loop: a scan every BOARD_SCAN_DELAY plus up to jitter milliseconds of
+ * work, a frame every BOARD_FRAME_DELAY from the previous one.
+ */
+static FlickerMetrics runMode(const char *name, LedStripRgbMode mode, uint16_t speed,
+  uint32_t duration, uint8_t jitter)
+{
+  LedStripRGB strip({ 0, 1, 3 });
+  strip.setup();
+  strip.setColor(COLOR_ORANGE);
+  strip.setMode(mode);
+  strip.setSpeed(speed);
+  strip.turnOn();
+  uint32_t start = millis();
+  uint32_t last_frame_time = start;
+  uint32_t seed = 7;
+  while(millis() - start < duration)
+  {
+    if((millis() - last_frame_time) >= BOARD_FRAME_DELAY)
+    {
+      last_frame_time += BOARD_FRAME_DELAY;
+      if((millis() - last_frame_time) >= BOARD_FRAME_DELAY)
+      {
+        last_frame_time = millis();
+      }
+      strip.loop();
+    }
+    seed = seed * 1103515245 + 12345;
+    delay(BOARD_SCAN_DELAY + (jitter > 0 ? (seed >> 16) % (jitter + 1) : 0));
+  }
+  // The first second is left for the ramp of the turn on
+  FlickerMetrics metrics = analyze(0x0B, start + 1000, millis());
+  printMetrics(name, metrics);
+  char path[PLOT_PATH];
+  plotPath(path, name);
+  plot(path, 0x0B, start + 1000, millis(), metrics);
+  return metrics;
+}
+
+void setUp(void)
+{
+  hostReset();
+  hostBoard().write_hook = recordWrite;
+  timeline_length = 0;
+  memset(timeline_duty, 0, sizeof(timeline_duty));
+}
+
+void tearDown(void)
+{
+}
+
+void test_steady_color_has_no_flicker(void)
+{
+  FlickerMetrics metrics = runMode("normal", LedStripRgbMode::NORMAL, DEFAULT_SPEED, 5000, 0);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 0, metrics.flicker_index);
+  TEST_ASSERT_EQUAL(0, metrics.updates);
+}
+
+/**
+ * Each change of the strobe is scheduled from the previous one, the half
+ * period is STROBE_DELAY with at most one frame of jitter.
+ */
+void test_strobe_keeps_its_period(void)
+{
+  FlickerMetrics metrics = runMode("strobe", LedStripRgbMode::STROBE, DEFAULT_SPEED, 10000, 3);
+  TEST_ASSERT_FLOAT_WITHIN(2.0, BOARD_STROBE_DELAY, metrics.mean_interval);
+  TEST_ASSERT_LESS_OR_EQUAL(BOARD_STROBE_DELAY + BOARD_FRAME_DELAY, metrics.max_interval);
+  TEST_ASSERT_GREATER_OR_EQUAL(BOARD_STROBE_DELAY - BOARD_FRAME_DELAY, metrics.min_interval);
+  TEST_ASSERT_FLOAT_WITHIN(0.05, 0.5, metrics.flicker_index);
+}
+
+/**
+ * The frames are scheduled from the previous frame: with up to 3 ms of work
+ * per scan the mean interval stays at BOARD_FRAME_DELAY.
+ */
+void test_fade_frame_rate_does_not_drift(void)
+{
+  FlickerMetrics metrics = runMode("fade", LedStripRgbMode::FADE, 512, 10000, 3);
+  TEST_ASSERT_FLOAT_WITHIN(0.5, BOARD_FRAME_DELAY, metrics.mean_interval);
+  TEST_ASSERT_LESS_OR_EQUAL(BOARD_FRAME_DELAY + BOARD_SCAN_DELAY + 3, metrics.max_interval);
+}
+
+/**
+ * A slow fade moves one step per frame. The steps are linear in duty, so the
+ * largest perceptual one is near black (0 to 5 is 15 L*).
+ */
+void test_slow_fade_steps_are_small(void)
+{
+  FlickerMetrics metrics = runMode("fade-slow", LedStripRgbMode::FADE, 768, 20000, 0);
+  TEST_ASSERT_TRUE(metrics.max_step <= 16.0);
+  TEST_ASSERT_EQUAL(BOARD_FRAME_DELAY, metrics.min_interval);
+  TEST_ASSERT_GREATER_THAN(0, metrics.updates);
+}
+
+void test_flash_and_flicker_modes_are_reported(void)
+{
+  runMode("flash", LedStripRgbMode::FLASH, 512, 10000, 3);
+  runMode("candle", LedStripRgbMode::CANDLE, DEFAULT_SPEED, 10000, 3);
+  FlickerMetrics fire = runMode("fire", LedStripRgbMode::FIRE, DEFAULT_SPEED, 10000, 3);
+  TEST_ASSERT_FLOAT_WITHIN(0.15, 0.15, fire.flicker_index);
+}
+
+/**
+ * A change of the brightness of the white LEDs (as the potentiometer does)
+ * ramps without visible steps.
+ */
+void test_white_ramp_is_smooth(void)
+{
+  LedStrip strip(4);
+  strip.setup();
+  strip.setIntensity(64);
+  strip.setRampTime(300);
+  strip.setRampEase(LedRampEase::SMOOTH);
+  delay(BOARD_SCAN_DELAY);
+  strip.loop();
+  uint32_t start = millis();
+  strip.setIntensity(255);
+  for(uint16_t i = 0; i < 100; i++)
+  {
+    delay(BOARD_SCAN_DELAY);
+    strip.loop();
+  }
+  FlickerMetrics metrics = analyze(0x10, start, millis());
+  printMetrics("white-ramp", metrics);
+  char path[PLOT_PATH];
+  plotPath(path, "white-ramp");
+  plot(path, 0x10, start, millis(), metrics);
+  TEST_ASSERT_TRUE(metrics.max_step <= 9.0);
+}
+
+/**
+ * Analyzes a timeline recorded by test_replay, each pin on its own.
+ */
+static int analyzeCsv(const char *csv)
+{
+  FILE *file = fopen(csv, "r");
+  if(file == nullptr)
+  {
+    return 1;
+  }
+  char line[64];
+  uint32_t mask = 0;
+  uint32_t end = 0;
+  while(fgets(line, sizeof(line), file) != nullptr && timeline_length < TIMELINE_SIZE)
+  {
+    unsigned time, pin, duty;
+    if(sscanf(line, "%u,%u,%u", &time, &pin, &duty) == 3 && pin < HOST_PINS)
+    {
+      timeline[timeline_length++] = { time, (uint8_t)pin, (uint8_t)duty };
+      mask |= 1UL << pin;
+      end = time + 1;
+    }
+  }
+  fclose(file);
+  for(uint8_t pin = 0; pin < HOST_PINS; pin++)
+  {
+    if((mask >> pin) & 1)
+    {
+      char name[16];
+      char path[PLOT_PATH];
+      snprintf(name, sizeof(name), "pin%u", pin);
+      FlickerMetrics metrics = analyze(1UL << pin, 0, end);
+      printMetrics(name, metrics);
+      plotPath(path, name);
+      plot(path, 1UL << pin, 0, end, metrics);
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  const char *csv = getenv("FLICKER_CSV");
+  if(csv != nullptr)
+  {
+    return analyzeCsv(csv);
+  }
+  UNITY_BEGIN();
+  RUN_TEST(test_steady_color_has_no_flicker);
+  RUN_TEST(test_strobe_keeps_its_period);
+  RUN_TEST(test_fade_frame_rate_does_not_drift);
+  RUN_TEST(test_slow_fade_steps_are_small);
+  RUN_TEST(test_flash_and_flicker_modes_are_reported);
+  RUN_TEST(test_white_ramp_is_smooth);
+  return UNITY_END();
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# fuzz.sh
+# Created by Jose Rivera, Feb 2018.
+#
+# This work is licensed under a Creative Commons Attribution 4.0 International License.
+# http://creativecommons.org/licenses/by/4.0/
+#
+# Runs the fuzz target of test_fuzz.cpp and reports the coverage of lib/.
+# With clang it is built with libFuzzer and the sanitizers, it runs for
+# FUZZ_TIME seconds (60 by default) from corpus/ and the new inputs are kept
+# in output/corpus. The coverage is reported with llvm-cov.
+# Without clang it is built with g++ and --coverage, the corpus is run once
+# and the coverage is reported with gcov.
+#
+# Usage, from the root of the project: sh test/test_fuzz/fuzz.sh
+
+set -e
+DIR=$(dirname "$0")
+OUT="$DIR/output"
+FUZZ_TIME=${FUZZ_TIME:-60}
+SOURCES="$DIR/test_fuzz.cpp $(ls lib/*/*.cpp)"
+INCLUDES="-I test/host $(for lib in lib/*/; do printf -- '-I %s ' "$lib"; done)"
+mkdir -p "$OUT/corpus"
+
+if command -v clang++ >/dev/null 2>&1; then
+  clang++ -std=gnu++11 -g -O1 -D FUZZING $INCLUDES \
+    -fsanitize=fuzzer,address,undefined -fprofile-instr-generate -fcoverage-mapping \
+    $SOURCES -o "$OUT/fuzz"
+  LLVM_PROFILE_FILE="$OUT/fuzz.profraw" "$OUT/fuzz" -max_total_time="$FUZZ_TIME" \
+    -max_len=4096 "$OUT/corpus" "$DIR/corpus"
+  llvm-profdata merge -sparse "$OUT/fuzz.profraw" -o "$OUT/fuzz.profdata"
+  llvm-cov report "$OUT/fuzz" -instr-profile="$OUT/fuzz.profdata" lib/
+else
+  echo "clang++ not found, the corpus is run once with the coverage of g++"
+  g++ -std=gnu++11 -g -O0 -D FUZZING -D FUZZ_STANDALONE $INCLUDES --coverage -Wno-int-to-pointer-cast \
+    -fsanitize=address,undefined $SOURCES -o "$OUT/fuzz"
+  "$OUT/fuzz" "$DIR"/corpus/*
+  gcov -n "$OUT"/fuzz-*.gcda | grep -A 1 "File 'lib/.*cpp'"
+fi
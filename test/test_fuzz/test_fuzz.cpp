@@ -0,0 +1,471 @@
+/*
+ * test_fuzz.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Fuzz target of the state machines of LedStrip, LedStripRGB and the button
+ * path (ButtonBank and BtnEventBus). The input is a sequence of operations of
+ * 2 bytes (operation and argument): calls of the public API, levels of the
+ * button and steps of time that run the loops as the sketch does. After each
+ * step of time the invariants are checked:
+ *  - a strip that is off, once its ramp is over, leaves its pins at the idle
+ *    level (0, or 255 for common anode),
+ *  - the duty of the pins matches the polarity: the requested duty, or 255
+ *    minus it for common anode,
+ *  - the events of the button follow the gestures: PRESS and RELEASE
+ *    alternate, LONG_PRESS and HOLD only while pressed, CLICK counts the
+ *    releases, and the debounced state follows a stable level.
+ *
+ * In the native env (pio test -e native) the inputs of corpus/ and a set of
+ * pseudo random inputs are run as a test. With clang the same file is a
+ * libFuzzer target (built with -D FUZZING), see fuzz.sh, which also reports
+ * the coverage of the libraries.
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "LedStrip.h"
+#include "LedStripRGB.h"
+#include "ButtonBank.h"
+#include "BtnEvents.h"
+
+#if defined(FUZZING)
+#define FUZZ_CHECK(condition, message) do { if(!(condition)) { \
+  fprintf(stderr, "%s\n", message); abort(); } } while(0)
+#else
+#include <dirent.h>
+#include <unity.h>
+#define FUZZ_CHECK(condition, message) TEST_ASSERT_TRUE_MESSAGE(condition, message)
+#endif
+
+#define FUZZ_WHITE_PIN 4
+#define FUZZ_BUTTON_PIN 2
+// Longest ramp of the operations, after it an off strip must be idle
+#define FUZZ_SETTLE_TIME (255UL * 8 + 255UL * 4 + BOARD_FRAME_DELAY * 2)
+
+enum FuzzOperation
+{
+  WHITE_ON,
+  WHITE_OFF,
+  WHITE_TOGGLE,
+  WHITE_INTENSITY,
+  WHITE_RAMP,
+  WHITE_ANODE,
+  WHITE_FLICKER,
+  WHITE_SCALE,
+  RGB_ON,
+  RGB_OFF,
+  RGB_TOGGLE,
+  RGB_COLOR,
+  RGB_MODE,
+  RGB_NEXT_MODE,
+  RGB_SPEED,
+  RGB_ANODE,
+  RGB_RAMP,
+  RGB_SCALE,
+  RGB_CROSS_FADE,
+  RGB_OVERLAY,
+  BUTTON,
+  ADVANCE,
+  FUZZ_OPERATIONS
+};
+
+/**
+ * What the listener expects of the events of the button.
+ */
+struct ButtonModel
+{
+  bool pressed;
+  bool long_pressed;
+  uint8_t releases;
+  uint8_t holds;
+  bool failed;
+  const char *error;
+};
+
+static ButtonModel button_model;
+
+static void fail(const char *error)
+{
+  if(!button_model.failed)
+  {
+    button_model.failed = true;
+    button_model.error = error;
+  }
+}
+
+static void buttonListener(void *context, BtnEvent event)
+{
+  ButtonModel &model = *static_cast<ButtonModel*>(context);
+  switch (event.type) {
+    case BtnEventType::PRESS:
+      if(model.pressed)
+      {
+        fail("PRESS while pressed");
+      }
+      model.pressed = true;
+      break;
+    case BtnEventType::RELEASE:
+      if(!model.pressed)
+      {
+        fail("RELEASE while released");
+      }
+      model.pressed = false;
+      if(model.long_pressed)
+      {
+        model.long_pressed = false;
+        model.releases = 0;
+      }
+      else
+      {
+        model.releases++;
+      }
+      break;
+    case BtnEventType::CLICK:
+      if(model.pressed || event.count == 0 || event.count != model.releases)
+      {
+        fail("CLICK does not count the releases");
+      }
+      model.releases = 0;
+      break;
+    case BtnEventType::LONG_PRESS:
+      if(!model.pressed || model.long_pressed)
+      {
+        fail("LONG_PRESS while not pressed");
+      }
+      model.long_pressed = true;
+      model.holds = 0;
+      break;
+    case BtnEventType::HOLD:
+      if(!model.long_pressed || event.count != (uint8_t)(model.holds + 1))
+      {
+        fail("HOLD out of a long press");
+      }
+      model.holds = event.count;
+      break;
+    default:
+      fail("unknown event");
+      break;
+  }
+}
+
+static uint8_t polarity(uint8_t duty, bool anode)
+{
+  return anode ? 255 - duty : duty;
+}
+
+/**
+ * Runs a sequence of operations and checks the invariants.
+ */
+static void runInput(const uint8_t *data, size_t size)
+{
+  hostReset();
+  HostBoard &board = hostBoard();
+  board.input[FUZZ_BUTTON_PIN] = LOW;
+  memset(&button_model, 0, sizeof(button_model));
+
+  LedStrip white(FUZZ_WHITE_PIN);
+  LedStripRGB rgb({ 0, 1, 3 });
+  BtnEventBus bus;
+  ButtonBank buttons(bus);
+  buttons.addButton(FUZZ_BUTTON_PIN, 0);
+  buttons.setup();
+  bus.subscribe(buttonListener, &button_model);
+  white.setup();
+  rgb.setup();
+
+  bool white_anode = false;
+  bool rgb_anode = false;
+  uint8_t white_scale = 255;
+  uint8_t rgb_scale = 255;
+  uint8_t white_flicker = 0;
+  uint32_t white_off_time = 0;
+  uint32_t rgb_off_time = 0;
+  uint8_t level = LOW;
+  uint8_t stable_scans = 0;
+  uint32_t last_frame_time = 0;
+
+  for(size_t i = 0; i + 1 < size; i += 2)
+  {
+    uint8_t argument = data[i + 1];
+    LedStripState white_state = white.getState();
+    LedStripState rgb_state = rgb.getState();
+    switch (data[i] % FUZZ_OPERATIONS) {
+      case WHITE_ON:
+        white.turnOn();
+        break;
+      case WHITE_OFF:
+        white.turnOff();
+        break;
+      case WHITE_TOGGLE:
+        white.toggle();
+        break;
+      case WHITE_INTENSITY:
+        white.setIntensity(argument);
+        break;
+      case WHITE_RAMP:
+        white.setRampTime((uint16_t)argument * 8);
+        white.setRampEase(argument & 1 ? LedRampEase::SMOOTH : LedRampEase::LINEAR);
+        break;
+      case WHITE_ANODE:
+        white_anode = argument & 1;
+        white.setCommonAnodeEnable(white_anode);
+        break;
+      case WHITE_FLICKER:
+        white_flicker = argument % 4;
+        white.setFlicker(static_cast<FlickerStyle>(white_flicker));
+        break;
+      case WHITE_SCALE:
+        white_scale = argument;
+        white.setOutputScale(argument);
+        break;
+      case RGB_ON:
+        rgb.turnOn();
+        break;
+      case RGB_OFF:
+        rgb.turnOff();
+        break;
+      case RGB_TOGGLE:
+        rgb.toggle();
+        break;
+      case RGB_COLOR:
+        rgb.setColor(pgm_read_dword(&FLASH_COLORS_SEQUENCE[argument % FLASH_COLORS_SEQUENCE_LENGTH]) ^
+          ((uint32_t)argument << 4));
+        break;
+      case RGB_MODE:
+        // MUSIC needs an analyzer, without it the color is shown
+        rgb.setMode(static_cast<LedStripRgbMode>(argument % 8));
+        break;
+      case RGB_NEXT_MODE:
+        rgb.nextMode();
+        break;
+      case RGB_SPEED:
+        rgb.setSpeed((uint16_t)argument * 4);
+        break;
+      case RGB_ANODE:
+        rgb_anode = argument & 1;
+        rgb.setCommonAnodeEnable(rgb_anode);
+        break;
+      case RGB_RAMP:
+        rgb.setRampTime((uint16_t)argument * 8);
+        break;
+      case RGB_SCALE:
+        rgb_scale = argument;
+        rgb.setOutputScale(argument);
+        break;
+      case RGB_CROSS_FADE:
+        rgb.crossFade((uint16_t)argument * 4);
+        break;
+      case RGB_OVERLAY:
+        if(argument & 0x80)
+        {
+          rgb.clearOverlays();
+        }
+        else
+        {
+          rgb.setOverlay(argument & 1, static_cast<LedOverlayMode>((argument >> 1) % 4),
+            argument << 6, argument << 1);
+        }
+        break;
+      case BUTTON:
+        level = argument & 1;
+        board.input[FUZZ_BUTTON_PIN] = level;
+        stable_scans = 0;
+        break;
+      case ADVANCE:
+      {
+        // The loops of the sketch: a scan every BOARD_SCAN_DELAY, a frame
+        // every BOARD_FRAME_DELAY and the events dispatched at the end
+        uint16_t time = (uint16_t)(argument + 1) * 4;
+        for(uint16_t elapsed = 0; elapsed < time; elapsed += BOARD_SCAN_DELAY)
+        {
+          delay(BOARD_SCAN_DELAY);
+          buttons.scan();
+          white.loop();
+          if(millis() - last_frame_time >= BOARD_FRAME_DELAY)
+          {
+            last_frame_time = millis();
+            rgb.loop();
+          }
+          bus.dispatch();
+          if(stable_scans < 0xFF)
+          {
+            stable_scans++;
+          }
+        }
+        rgb.loop();
+        break;
+      }
+      default:
+        break;
+    }
+    if(white_state == LedStripState::ON && white.getState() == LedStripState::OFF)
+    {
+      white_off_time = millis();
+    }
+    if(rgb_state == LedStripState::ON && rgb.getState() == LedStripState::OFF)
+    {
+      rgb_off_time = millis();
+    }
+    if(data[i] % FUZZ_OPERATIONS != ADVANCE)
+    {
+      continue;
+    }
+
+    FUZZ_CHECK(!button_model.failed, button_model.error);
+    if(stable_scans > 4)
+    {
+      FUZZ_CHECK(button_model.pressed == (level == HIGH), "button does not follow a stable level");
+    }
+
+    uint8_t white_pin = board.duty[FUZZ_WHITE_PIN];
+    if(white.getState() == LedStripState::OFF &&
+      (white.getDuty() == 0 || millis() - white_off_time > FUZZ_SETTLE_TIME))
+    {
+      FUZZ_CHECK(white_pin == polarity(0, white_anode), "white off is not idle");
+    }
+    else if(white_flicker == 0 && white_scale == 255)
+    {
+      FUZZ_CHECK(white_pin == polarity(white.getDuty(), white_anode), "white duty does not match the polarity");
+    }
+    else
+    {
+      FUZZ_CHECK(polarity(white_pin, white_anode) <= white.getDuty(), "white duty over the requested one");
+    }
+
+    RGBColor color = rgb.getOutputColor();
+    uint8_t pins[3] = { board.duty[0], board.duty[1], board.duty[3] };
+    uint8_t requested[3] = { color.red, color.green, color.blue };
+    bool rgb_idle = rgb.getState() == LedStripState::OFF &&
+      millis() - rgb_off_time > FUZZ_SETTLE_TIME;
+    for(uint8_t c = 0; c < 3; c++)
+    {
+      if(rgb_idle)
+      {
+        FUZZ_CHECK(pins[c] == polarity(0, rgb_anode), "RGB off is not idle");
+      }
+      else if(rgb_scale == 255)
+      {
+        FUZZ_CHECK(pins[c] == polarity(requested[c], rgb_anode), "RGB duty does not match the polarity");
+      }
+      else
+      {
+        FUZZ_CHECK(polarity(pins[c], rgb_anode) <= requested[c], "RGB duty over the requested one");
+      }
+    }
+  }
+}
+
+#if defined(FUZZING)
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  runInput(data, size);
+  return 0;
+}
+
+#if defined(FUZZ_STANDALONE)
+/**
+ * Without libFuzzer the inputs given as arguments are run once, for the
+ * coverage of the corpus.
+ */
+int main(int argc, char **argv)
+{
+  static uint8_t data[4096];
+  for(int i = 1; i < argc; i++)
+  {
+    FILE *file = fopen(argv[i], "rb");
+    if(file == nullptr)
+    {
+      continue;
+    }
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+    LLVMFuzzerTestOneInput(data, size);
+  }
+  return 0;
+}
+#endif
+#else
+
+/**
+ * Directory of this file, the corpus is in corpus/.
+ */
+static void corpusPath(char *path, size_t size, const char *name)
+{
+  const char *file = __FILE__;
+  const char *slash = strrchr(file, '/');
+  int length = slash != nullptr ? slash - file : 1;
+  snprintf(path, size, "%.*s/corpus", length, slash != nullptr ? file : ".");
+  if(name != nullptr)
+  {
+    strncat(path, "/", size - strlen(path) - 1);
+    strncat(path, name, size - strlen(path) - 1);
+  }
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_corpus(void)
+{
+  char path[512];
+  corpusPath(path, sizeof(path), nullptr);
+  DIR *dir = opendir(path);
+  TEST_ASSERT_TRUE_MESSAGE(dir != nullptr, path);
+  uint16_t inputs = 0;
+  struct dirent *entry;
+  while((entry = readdir(dir)) != nullptr)
+  {
+    if(entry->d_name[0] == '.')
+    {
+      continue;
+    }
+    corpusPath(path, sizeof(path), entry->d_name);
+    FILE *file = fopen(path, "rb");
+    TEST_ASSERT_TRUE_MESSAGE(file != nullptr, path);
+    uint8_t data[4096];
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+    runInput(data, size);
+    inputs++;
+  }
+  closedir(dir);
+  TEST_ASSERT_GREATER_THAN(0, inputs);
+}
+
+/**
+ * Pseudo random sequences with a fixed seed, biased to the steps of time.
+ */
+void test_random_sequences(void)
+{
+  uint32_t seed = 0x2018;
+  uint8_t data[512];
+  for(uint16_t input = 0; input < 500; input++)
+  {
+    for(uint16_t i = 0; i < sizeof(data); i += 2)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = (seed >> 24) & 1 ? (uint8_t)ADVANCE : (uint8_t)((seed >> 16) % FUZZ_OPERATIONS);
+      data[i + 1] = seed >> 8;
+    }
+    runInput(data, sizeof(data));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_corpus);
+  RUN_TEST(test_random_sequences);
+  return UNITY_END();
+}
+#endif
@@ -0,0 +1,247 @@
+/*
+ * test_led_ramp.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Ramps of LedRamp and the soft transitions of LedStrip: monotonic, without
+ * jumps between frames, ending on the target in the given time.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "LedRamp.h"
+#include "LedStrip.h"
+
+#define FRAME 20
+
+/**
+ * Runs a ramp frame by frame and checks that each frame moves towards the
+ * target by at most max_step.
+ * @return Milliseconds to reach the target
+ */
+static uint32_t runRamp(LedRamp &ramp, uint8_t target, uint8_t max_step)
+{
+  uint8_t from = ramp.getValue();
+  bool up = target > from;
+  ramp.setTarget(target);
+  uint32_t time = 0;
+  uint8_t last = from;
+  while(ramp.isRunning())
+  {
+    TEST_ASSERT_LESS_THAN(60000, time);
+    ramp.step(FRAME);
+    time += FRAME;
+    uint8_t value = ramp.getValue();
+    if(up)
+    {
+      TEST_ASSERT_GREATER_OR_EQUAL(last, value);
+      TEST_ASSERT_LESS_OR_EQUAL(target, value);
+      TEST_ASSERT_LESS_OR_EQUAL(max_step, value - last);
+    }
+    else
+    {
+      TEST_ASSERT_LESS_OR_EQUAL(last, value);
+      TEST_ASSERT_GREATER_OR_EQUAL(target, value);
+      TEST_ASSERT_LESS_OR_EQUAL(max_step, last - value);
+    }
+    last = value;
+  }
+  TEST_ASSERT_EQUAL(target, ramp.getValue());
+  return time;
+}
+
+void setUp(void)
+{
+  hostReset();
+}
+
+void tearDown(void)
+{
+}
+
+void test_no_ramp_time_is_immediate(void)
+{
+  LedRamp ramp;
+  ramp.setTarget(200);
+  TEST_ASSERT_EQUAL(200, ramp.getValue());
+  TEST_ASSERT_FALSE(ramp.isRunning());
+}
+
+void test_linear_ramp_is_monotonic_and_on_time(void)
+{
+  const uint16_t times[] = { 100, 500, 1000, 3000 };
+  for(uint8_t i = 0; i < 4; i++)
+  {
+    LedRamp ramp;
+    ramp.setTime(times[i]);
+    uint8_t max_step = 255UL * FRAME / times[i] + 1;
+    uint32_t up = runRamp(ramp, 255, max_step);
+    TEST_ASSERT_INT_WITHIN(FRAME + times[i] / 25, times[i], up);
+    uint32_t down = runRamp(ramp, 0, max_step);
+    TEST_ASSERT_INT_WITHIN(FRAME + times[i] / 25, times[i], down);
+  }
+}
+
+/**
+ * A partial ramp takes the part of the time of the full scale.
+ */
+void test_linear_ramp_time_is_proportional(void)
+{
+  LedRamp ramp;
+  ramp.setTime(1000);
+  uint32_t time = runRamp(ramp, 64, 6);
+  TEST_ASSERT_INT_WITHIN(FRAME + 10, 251, time);
+}
+
+void test_smooth_ramp_is_monotonic_and_slows_down(void)
+{
+  LedRamp ramp;
+  ramp.setTime(1000);
+  ramp.setEase(LedRampEase::SMOOTH);
+  ramp.setTarget(255);
+  uint8_t first = 0;
+  uint8_t last = 0;
+  uint8_t last_step = 255;
+  uint32_t time = 0;
+  while(ramp.isRunning())
+  {
+    ramp.step(FRAME);
+    time += FRAME;
+    uint8_t value = ramp.getValue();
+    TEST_ASSERT_GREATER_OR_EQUAL(last, value);
+    uint8_t step = value - last;
+    if(first == 0)
+    {
+      first = step;
+    }
+    // The steps get shorter, one count of rounding apart
+    TEST_ASSERT_LESS_OR_EQUAL(last_step + 1, step);
+    last_step = step;
+    last = value;
+  }
+  TEST_ASSERT_EQUAL(255, ramp.getValue());
+  TEST_ASSERT_GREATER_THAN(16, first);
+  TEST_ASSERT_LESS_OR_EQUAL(2000, time);
+}
+
+/**
+ * A new target in the middle of a ramp turns back from the current value.
+ */
+void test_new_target_turns_back_without_a_jump(void)
+{
+  LedRamp ramp;
+  ramp.setTime(1000);
+  ramp.setTarget(255);
+  for(uint8_t i = 0; i < 25; i++)
+  {
+    ramp.step(FRAME);
+  }
+  uint8_t middle = ramp.getValue();
+  TEST_ASSERT_INT_WITHIN(4, 127, middle);
+  ramp.setTarget(0);
+  TEST_ASSERT_EQUAL(middle, ramp.getValue());
+  runRamp(ramp, 0, 6);
+}
+
+/**
+ * A late frame does not jump more than LED_RAMP_MAX_STEP of ramp.
+ */
+void test_long_step_is_limited(void)
+{
+  LedRamp ramp;
+  ramp.setTime(1000);
+  ramp.setTarget(255);
+  ramp.step(5000);
+  TEST_ASSERT_INT_WITHIN(1, 255UL * LED_RAMP_MAX_STEP / 1000, ramp.getValue());
+}
+
+void test_step_reports_the_changes(void)
+{
+  LedRamp ramp;
+  ramp.setTime(10000);
+  ramp.setTarget(255);
+  TEST_ASSERT_FALSE(ramp.step(1));
+  TEST_ASSERT_TRUE(ramp.step(FRAME * 20));
+  ramp.jumpTo(10);
+  TEST_ASSERT_FALSE(ramp.step(FRAME));
+}
+
+/**
+ * The strip turns on and off through the ramp, and the pin is left at its
+ * idle level at the end.
+ */
+void test_strip_soft_on_and_off(void)
+{
+  HostBoard &board = hostBoard();
+  LedStrip strip(4);
+  strip.setup();
+  strip.setRampTime(500);
+  strip.setIntensity(200);
+  uint8_t last = board.duty[4];
+  TEST_ASSERT_LESS_OR_EQUAL(11, last);
+  for(uint8_t frame = 0; frame < 40; frame++)
+  {
+    delay(FRAME);
+    strip.loop();
+    TEST_ASSERT_GREATER_OR_EQUAL(last, board.duty[4]);
+    TEST_ASSERT_LESS_OR_EQUAL(11, board.duty[4] - last);
+    last = board.duty[4];
+  }
+  TEST_ASSERT_EQUAL(200, board.duty[4]);
+  strip.turnOff();
+  TEST_ASSERT_EQUAL(200, board.duty[4]);
+  for(uint8_t frame = 0; frame < 40; frame++)
+  {
+    delay(FRAME);
+    strip.loop();
+    TEST_ASSERT_LESS_OR_EQUAL(last, board.duty[4]);
+    TEST_ASSERT_LESS_OR_EQUAL(11, last - board.duty[4]);
+    last = board.duty[4];
+  }
+  TEST_ASSERT_EQUAL(0, board.duty[4]);
+  TEST_ASSERT_EQUAL(LedStripState::OFF, strip.getState());
+}
+
+/**
+ * Moving the potentiometer fast ramps from the current duty, it never jumps.
+ */
+void test_strip_follows_a_fast_pot(void)
+{
+  HostBoard &board = hostBoard();
+  LedStrip strip(4);
+  strip.setup();
+  strip.setRampTime(500);
+  strip.turnOn();
+  uint8_t last = board.duty[4];
+  for(uint16_t frame = 0; frame < 200; frame++)
+  {
+    if(frame % 5 == 0)
+    {
+      strip.setIntensity(frame % 10 == 0 ? 255 : 1);
+    }
+    delay(FRAME);
+    strip.loop();
+    int16_t change = (int16_t)board.duty[4] - last;
+    TEST_ASSERT_LESS_OR_EQUAL(11, change < 0 ? -change : change);
+    last = board.duty[4];
+  }
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_no_ramp_time_is_immediate);
+  RUN_TEST(test_linear_ramp_is_monotonic_and_on_time);
+  RUN_TEST(test_linear_ramp_time_is_proportional);
+  RUN_TEST(test_smooth_ramp_is_monotonic_and_slows_down);
+  RUN_TEST(test_new_target_turns_back_without_a_jump);
+  RUN_TEST(test_long_step_is_limited);
+  RUN_TEST(test_step_reports_the_changes);
+  RUN_TEST(test_strip_soft_on_and_off);
+  RUN_TEST(test_strip_follows_a_fast_pot);
+  return UNITY_END();
+}
@@ -0,0 +1,295 @@
+/*
+ * test_noise.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Statistical and spectral tests of the noise of Lfsr and Flicker: period
+ * and balance of the LFSR, distribution and correlation of the random bytes,
+ * range of the levels of each style and the spectrum of the flicker, sampled
+ * every FLICKER_STEP (50 Hz).
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <unity.h>
+#include "Lfsr.h"
+#include "Flicker.h"
+
+// Samples of the spectrum, 41 seconds of flicker
+#define NOISE_SAMPLES 2048
+// Chi-square of 255 degrees of freedom with p = 0.001
+#define NOISE_CHI_SQUARE 330.5
+
+/**
+ * A random byte as Flicker draws it, 8 steps of the LFSR.
+ */
+static uint8_t random8(Lfsr &lfsr)
+{
+  for(uint8_t i = 0; i < 7; i++)
+  {
+    lfsr.next();
+  }
+  return lfsr.next();
+}
+
+/**
+ * Levels of a style sampled every FLICKER_STEP, after the filter settled.
+ */
+static void sampleLevels(FlickerStyle style, double *levels, uint16_t count)
+{
+  Flicker flicker;
+  for(uint16_t i = 0; i < 256; i++)
+  {
+    flicker.step(style, FLICKER_STEP);
+  }
+  for(uint16_t i = 0; i < count; i++)
+  {
+    flicker.step(style, FLICKER_STEP);
+    levels[i] = flicker.getLevel();
+  }
+}
+
+/**
+ * Spectral centroid (Hz) of the levels and the share of their power below
+ * the given frequency, from a plain DFT of the variations over the mean.
+ */
+static double spectrum(const double *levels, double below, double &low_share)
+{
+  double mean = 0;
+  for(uint16_t i = 0; i < NOISE_SAMPLES; i++)
+  {
+    mean += levels[i];
+  }
+  mean /= NOISE_SAMPLES;
+  double rate = 1000.0 / FLICKER_STEP;
+  double total = 0;
+  double centroid = 0;
+  double low = 0;
+  for(uint16_t k = 1; k <= NOISE_SAMPLES / 2; k++)
+  {
+    double re = 0;
+    double im = 0;
+    for(uint16_t i = 0; i < NOISE_SAMPLES; i++)
+    {
+      double angle = 2 * M_PI * k * i / NOISE_SAMPLES;
+      re += (levels[i] - mean) * cos(angle);
+      im -= (levels[i] - mean) * sin(angle);
+    }
+    double power = re * re + im * im;
+    double frequency = rate * k / NOISE_SAMPLES;
+    total += power;
+    centroid += power * frequency;
+    if(frequency < below)
+    {
+      low += power;
+    }
+  }
+  low_share = low / total;
+  return centroid / total;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * Maximal length: every state but zero once before the sequence repeats.
+ */
+void test_lfsr_has_the_full_period(void)
+{
+  static uint8_t seen[8192];
+  memset(seen, 0, sizeof(seen));
+  Lfsr lfsr(0xACE1);
+  uint32_t period = 0;
+  uint16_t state;
+  do
+  {
+    state = lfsr.next();
+    TEST_ASSERT_NOT_EQUAL(0, state);
+    TEST_ASSERT_FALSE(seen[state >> 3] & (1 << (state & 7)));
+    seen[state >> 3] |= 1 << (state & 7);
+    period++;
+  } while(state != 0xACE1 && period <= 65535);
+  TEST_ASSERT_EQUAL(65535, period);
+}
+
+void test_lfsr_zero_seed_is_replaced(void)
+{
+  Lfsr zero(0);
+  Lfsr fallback(0xACE1);
+  for(uint8_t i = 0; i < 16; i++)
+  {
+    TEST_ASSERT_EQUAL_HEX16(fallback.next(), zero.next());
+  }
+}
+
+/**
+ * Over a period each bit of the state is set in 32768 of the 65535 states.
+ */
+void test_lfsr_bits_are_balanced(void)
+{
+  uint32_t ones[16] = {};
+  Lfsr lfsr;
+  for(uint32_t i = 0; i < 65535; i++)
+  {
+    uint16_t state = lfsr.next();
+    for(uint8_t bit = 0; bit < 16; bit++)
+    {
+      ones[bit] += (state >> bit) & 1;
+    }
+  }
+  for(uint8_t bit = 0; bit < 16; bit++)
+  {
+    TEST_ASSERT_EQUAL(32768, ones[bit]);
+  }
+}
+
+/**
+ * The bytes drawn by the flicker are uniform (chi-square) on a short window
+ * and not correlated with the previous one.
+ */
+void test_random_bytes_are_uniform_and_independent(void)
+{
+  const uint16_t draws = 4096;
+  uint16_t histogram[256] = {};
+  Lfsr lfsr;
+  double sum = 0;
+  double squares = 0;
+  double products = 0;
+  uint8_t previous = random8(lfsr);
+  for(uint16_t i = 0; i < draws; i++)
+  {
+    uint8_t value = random8(lfsr);
+    histogram[value]++;
+    sum += value;
+    squares += (double)value * value;
+    products += (double)previous * value;
+    previous = value;
+  }
+  double expected = draws / 256.0;
+  double chi_square = 0;
+  for(uint16_t i = 0; i < 256; i++)
+  {
+    chi_square += (histogram[i] - expected) * (histogram[i] - expected) / expected;
+  }
+  double mean = sum / draws;
+  double variance = squares / draws - mean * mean;
+  double correlation = (products / draws - mean * mean) / variance;
+  TEST_ASSERT_TRUE(chi_square < NOISE_CHI_SQUARE);
+  TEST_ASSERT_INT_WITHIN(4, 128, (int)mean);
+  TEST_ASSERT_TRUE(fabs(correlation) < 0.05);
+}
+
+/**
+ * Each style keeps its level in its band: the candle near full with dips,
+ * the fire deep and wide, the twinkle on its floor with sparkles.
+ */
+void test_levels_stay_in_the_band_of_the_style(void)
+{
+  static double levels[NOISE_SAMPLES];
+  const FlickerStyle styles[] = {
+    FlickerStyle::FLICKER_CANDLE, FlickerStyle::FLICKER_FIRE, FlickerStyle::FLICKER_TWINKLE
+  };
+  const uint8_t floors[] = { 96, 64, 176 };
+  const uint8_t mean_min[] = { 200, 130, 176 };
+  const uint8_t mean_max[] = { 240, 190, 200 };
+  const uint8_t deviation_min[] = { 4, 20, 5 };
+  const uint8_t deviation_max[] = { 20, 50, 30 };
+  for(uint8_t s = 0; s < 3; s++)
+  {
+    sampleLevels(styles[s], levels, NOISE_SAMPLES);
+    double sum = 0;
+    double squares = 0;
+    for(uint16_t i = 0; i < NOISE_SAMPLES; i++)
+    {
+      TEST_ASSERT_GREATER_OR_EQUAL(floors[s], (uint8_t)levels[i]);
+      sum += levels[i];
+      squares += levels[i] * levels[i];
+    }
+    double mean = sum / NOISE_SAMPLES;
+    double deviation = sqrt(squares / NOISE_SAMPLES - mean * mean);
+    TEST_ASSERT_TRUE(mean >= mean_min[s] && mean <= mean_max[s]);
+    TEST_ASSERT_TRUE(deviation >= deviation_min[s] && deviation <= deviation_max[s]);
+  }
+}
+
+/**
+ * The low pass shapes the noise: unlike white noise (centroid at a quarter
+ * of the sample rate, 12.5 Hz) the power is in the slow flicker, the fire
+ * is the fastest and the candle wavers below 5 Hz.
+ */
+void test_spectrum_is_low_pass(void)
+{
+  static double levels[NOISE_SAMPLES];
+  double candle_low;
+  double fire_low;
+  double twinkle_low;
+  sampleLevels(FlickerStyle::FLICKER_CANDLE, levels, NOISE_SAMPLES);
+  double candle = spectrum(levels, 5, candle_low);
+  sampleLevels(FlickerStyle::FLICKER_FIRE, levels, NOISE_SAMPLES);
+  double fire = spectrum(levels, 5, fire_low);
+  sampleLevels(FlickerStyle::FLICKER_TWINKLE, levels, NOISE_SAMPLES);
+  double twinkle = spectrum(levels, 5, twinkle_low);
+  char message[96];
+  snprintf(message, sizeof(message), "centroid candle %.1f Hz, fire %.1f Hz, twinkle %.1f Hz",
+    candle, fire, twinkle);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(fire < 10);
+  TEST_ASSERT_TRUE(candle < fire);
+  TEST_ASSERT_TRUE(twinkle < fire);
+  TEST_ASSERT_TRUE(candle_low > 0.6);
+  TEST_ASSERT_TRUE(twinkle_low > 0.6);
+  TEST_ASSERT_TRUE(fire_low > 0.3);
+}
+
+/**
+ * The noise advances with the time, not with the calls: at the same
+ * moments the level is the same for frames of 7, 10 and 20 ms.
+ */
+void test_noise_does_not_depend_on_the_frame_rate(void)
+{
+  const uint8_t frames[] = { 7, 10, 20 };
+  uint8_t reference[64];
+  for(uint8_t f = 0; f < 3; f++)
+  {
+    Flicker flicker;
+    uint32_t time = 0;
+    for(uint8_t sample = 0; sample < 64; sample++)
+    {
+      // 140 ms is a multiple of the three frames
+      for(uint32_t end = time + 140; time < end; time += frames[f])
+      {
+        flicker.step(FlickerStyle::FLICKER_FIRE, frames[f]);
+      }
+      if(f == 0)
+      {
+        reference[sample] = flicker.getLevel();
+      }
+      else
+      {
+        TEST_ASSERT_EQUAL(reference[sample], flicker.getLevel());
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_lfsr_has_the_full_period);
+  RUN_TEST(test_lfsr_zero_seed_is_replaced);
+  RUN_TEST(test_lfsr_bits_are_balanced);
+  RUN_TEST(test_random_bytes_are_uniform_and_independent);
+  RUN_TEST(test_levels_stay_in_the_band_of_the_style);
+  RUN_TEST(test_spectrum_is_low_pass);
+  RUN_TEST(test_noise_does_not_depend_on_the_frame_rate);
+  return UNITY_END();
+}
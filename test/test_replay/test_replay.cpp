@@ -0,0 +1,341 @@
+/*
+ * test_replay.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Record and replay of the sketch: the traces of traces/ are replayed through
+ * the real src/main.cpp (buttons, potentiometer, LEDs and clock) on the
+ * simulated board, and the timeline of the duties written to the LED pins is
+ * compared with the golden one of golden/.
+ *
+ * A trace is a text file with an event per line, sorted by time:
+ *   <milliseconds since power on> <input> <value>
+ * where the input is pot or ldr (value of the ADC, 0 - 1023), btn (level of
+ * the pin of the mode button, 1 is pressed) or end (the replay stops). The
+ * events at time 0 are set before setup(). Lines starting with # are
+ * comments. The watchdog ticks every second of the simulated time.
+ *
+ * Each replay writes to output/ the timeline as CSV (time_ms,pin,duty) and
+ * as a binary log of 6 bytes per change (time in ms as 32 bits little endian,
+ * pin, duty), only the changes of duty are recorded. After a change of the
+ * sketch that is intended, the golden files are written again with
+ *   REPLAY_UPDATE=1 .pio/build/native/program
+ * Each trace runs in its own process, so all of them start from a power on.
+ */
+
+#include "../../src/main.cpp"
+#include <stdio.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+
+// Period of the watchdog tick in milliseconds
+#define REPLAY_TICK 1000
+#define REPLAY_PATH 160
+
+static char replay_dir[REPLAY_PATH - 64];
+static FILE *timeline_csv = nullptr;
+static FILE *timeline_log = nullptr;
+static uint8_t timeline_duty[HOST_PINS];
+
+/**
+ * Directory of this file, traces/, golden/ and output/ are found from it.
+ */
+static void findReplayDir(void)
+{
+  strncpy(replay_dir, __FILE__, sizeof(replay_dir) - 1);
+  char *slash = strrchr(replay_dir, '/');
+  if(slash != nullptr)
+  {
+    *slash = '\0';
+  }
+  else
+  {
+    strcpy(replay_dir, ".");
+  }
+}
+
+static void replayPath(char *path, const char *folder, const char *name, const char *extension)
+{
+  snprintf(path, REPLAY_PATH, "%s/%s/%s%s", replay_dir, folder, name, extension);
+}
+
+/**
+ * Hook of the simulated board, records the changes of duty.
+ */
+static void recordWrite(uint8_t pin, uint8_t duty)
+{
+  pin %= HOST_PINS;
+  if(timeline_duty[pin] == duty)
+  {
+    return;
+  }
+  timeline_duty[pin] = duty;
+  uint32_t time = millis();
+  fprintf(timeline_csv, "%u,%u,%u\n", (unsigned)time, pin, duty);
+  uint8_t record[6] = {
+    (uint8_t)time, (uint8_t)(time >> 8), (uint8_t)(time >> 16), (uint8_t)(time >> 24),
+    pin, duty
+  };
+  fwrite(record, 1, sizeof(record), timeline_log);
+}
+
+static void applyInput(const char *input, uint16_t value)
+{
+  HostBoard &board = hostBoard();
+  if(strcmp(input, "pot") == 0)
+  {
+    board.analog[pot_color_pin] = value;
+  }
+#ifdef BOARD_LDR_PIN
+  else if(strcmp(input, "ldr") == 0)
+  {
+    board.analog[BOARD_LDR_PIN] = value;
+  }
+#endif
+  else if(strcmp(input, "btn") == 0)
+  {
+    board.input[btn_mode_pin] = value ? HIGH : LOW;
+  }
+}
+
+/**
+ * Runs the loop of the sketch until the given time, with the ticks of the
+ * watchdog.
+ */
+static void runUntil(uint32_t time, uint32_t &next_tick)
+{
+  while(millis() < time)
+  {
+    if(millis() >= next_tick)
+    {
+      next_tick += REPLAY_TICK;
+      rtc.tick();
+    }
+    loop();
+  }
+}
+
+/**
+ * Replays a trace from a power on, the timeline is written to output/.
+ * @return false if the trace or the output can not be opened
+ */
+static bool replay(const char *trace_path, const char *name)
+{
+  char path[REPLAY_PATH];
+  FILE *trace = fopen(trace_path, "r");
+  snprintf(path, sizeof(path), "%s/output", replay_dir);
+  mkdir(path, 0755);
+  replayPath(path, "output", name, ".csv");
+  timeline_csv = fopen(path, "w");
+  replayPath(path, "output", name, ".bin");
+  timeline_log = fopen(path, "wb");
+  if(trace == nullptr || timeline_csv == nullptr || timeline_log == nullptr)
+  {
+    return false;
+  }
+  fputs("time_ms,pin,duty\n", timeline_csv);
+
+  hostReset();
+  hostBoard().input[btn_mode_pin] = LOW;
+  hostBoard().write_hook = recordWrite;
+  memset(timeline_duty, 0, sizeof(timeline_duty));
+  bool started = false;
+  uint32_t next_tick = REPLAY_TICK;
+  char line[64];
+  while(fgets(line, sizeof(line), trace) != nullptr)
+  {
+    unsigned long time;
+    char input[8];
+    unsigned value = 0;
+    if(line[0] == '#' || sscanf(line, "%lu %7s %u", &time, input, &value) < 2)
+    {
+      continue;
+    }
+    if(time > 0 && !started)
+    {
+      setup();
+      started = true;
+    }
+    runUntil(time, next_tick);
+    if(strcmp(input, "end") == 0)
+    {
+      break;
+    }
+    applyInput(input, value);
+  }
+  fclose(trace);
+  fclose(timeline_csv);
+  fclose(timeline_log);
+  return true;
+}
+
+/**
+ * Replays a trace in a child process, so the globals of the sketch start from
+ * a power on on every trace.
+ */
+static bool replayInProcess(const char *trace_path, const char *name)
+{
+  fflush(stdout);
+  pid_t pid = fork();
+  if(pid == 0)
+  {
+    _exit(replay(trace_path, name) ? 0 : 1);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * Compares the timeline with the golden one, line by line, or writes the
+ * golden one when REPLAY_UPDATE is set.
+ */
+static void checkGolden(const char *name)
+{
+  char output_path[REPLAY_PATH];
+  char golden_path[REPLAY_PATH];
+  replayPath(output_path, "output", name, ".csv");
+  replayPath(golden_path, "golden", name, ".csv");
+  FILE *output = fopen(output_path, "r");
+  TEST_ASSERT_TRUE_MESSAGE(output != nullptr, output_path);
+  if(getenv("REPLAY_UPDATE") != nullptr)
+  {
+    FILE *golden = fopen(golden_path, "w");
+    TEST_ASSERT_TRUE_MESSAGE(golden != nullptr, golden_path);
+    int c;
+    while((c = fgetc(output)) != EOF)
+    {
+      fputc(c, golden);
+    }
+    fclose(golden);
+    fclose(output);
+    TEST_MESSAGE(golden_path);
+    return;
+  }
+  FILE *golden = fopen(golden_path, "r");
+  TEST_ASSERT_TRUE_MESSAGE(golden != nullptr, golden_path);
+  char expected[32];
+  char actual[32];
+  char message[128];
+  for(uint32_t number = 1; ; number++)
+  {
+    bool has_expected = fgets(expected, sizeof(expected), golden) != nullptr;
+    bool has_actual = fgets(actual, sizeof(actual), output) != nullptr;
+    if(!has_expected && !has_actual)
+    {
+      break;
+    }
+    if(!has_expected || !has_actual || strcmp(expected, actual) != 0)
+    {
+      expected[strcspn(expected, "\n")] = '\0';
+      actual[strcspn(actual, "\n")] = '\0';
+      snprintf(message, sizeof(message), "%s line %u: expected '%s' got '%s'", name,
+        (unsigned)number, has_expected ? expected : "end", has_actual ? actual : "end");
+      fclose(golden);
+      fclose(output);
+      TEST_FAIL_MESSAGE(message);
+    }
+  }
+  fclose(golden);
+  fclose(output);
+}
+
+static void replayTrace(const char *name)
+{
+  char path[REPLAY_PATH];
+  replayPath(path, "traces", name, ".trace");
+  TEST_ASSERT_TRUE_MESSAGE(replayInProcess(path, name), path);
+  checkGolden(name);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_power_on(void)
+{
+  replayTrace("power_on");
+}
+
+void test_pot_wiggle_then_press(void)
+{
+  replayTrace("pot_wiggle_then_press");
+}
+
+void test_modes(void)
+{
+  replayTrace("modes");
+}
+
+void test_off_and_turn_on_threshold(void)
+{
+  replayTrace("off_and_turn_on_threshold");
+}
+
+void test_clock_and_schedule(void)
+{
+  replayTrace("clock_and_schedule");
+}
+
+/**
+ * A day of use generated with a fixed seed: the schedule is enabled and the
+ * potentiometer moves every few minutes. It must run in seconds.
+ */
+void test_day_replays_in_seconds(void)
+{
+  char path[REPLAY_PATH];
+  snprintf(path, sizeof(path), "%s/output", replay_dir);
+  mkdir(path, 0755);
+  replayPath(path, "output", "day", ".trace");
+  FILE *trace = fopen(path, "w");
+  TEST_ASSERT_TRUE_MESSAGE(trace != nullptr, path);
+  fprintf(trace, "0 pot 512\n0 btn 0\n");
+  // Five clicks set the clock and enable the schedule
+  for(uint8_t click = 0; click < 5; click++)
+  {
+    fprintf(trace, "%u btn 1\n%u btn 0\n", 5000 + click * 200, 5100 + click * 200);
+  }
+  uint32_t seed = 1;
+  uint16_t pot = 512;
+  for(uint32_t time = 60000; time < SECONDS_PER_DAY * 1000; time += 180000)
+  {
+    seed = seed * 1103515245 + 12345;
+    pot = constrain((int16_t)pot + (int16_t)((seed >> 16) % 201) - 100, 0, 1023);
+    fprintf(trace, "%u pot %u\n", (unsigned)time, pot);
+  }
+  fprintf(trace, "%lu end\n", SECONDS_PER_DAY * 1000);
+  fclose(trace);
+
+  time_t start = time(nullptr);
+  TEST_ASSERT_TRUE(replayInProcess(path, "day"));
+  TEST_ASSERT_LESS_OR_EQUAL(30, time(nullptr) - start);
+  replayPath(path, "output", "day", ".bin");
+  struct stat log;
+  TEST_ASSERT_EQUAL(0, stat(path, &log));
+  TEST_ASSERT_EQUAL(0, log.st_size % 6);
+  TEST_ASSERT_GREATER_THAN(0, log.st_size);
+}
+
+int main(int argc, char **argv)
+{
+  findReplayDir();
+  UNITY_BEGIN();
+  RUN_TEST(test_power_on);
+  RUN_TEST(test_pot_wiggle_then_press);
+  RUN_TEST(test_modes);
+  RUN_TEST(test_off_and_turn_on_threshold);
+  RUN_TEST(test_clock_and_schedule);
+  RUN_TEST(test_day_replays_in_seconds);
+  return UNITY_END();
+}
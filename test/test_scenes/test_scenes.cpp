@@ -0,0 +1,165 @@
+/*
+ * test_scenes.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Scenes of SceneStore in the EEPROM of the host: the cross fade of a
+ * recall, the modes read from an EEPROM that this build can not show and the
+ * scenes saved while the color temperature mode borrows the RGB LEDs.
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <unity.h>
+#include "SceneStore.h"
+#include "RGBColors.h"
+
+#define BLUE_PIN 3
+#define WHITE_PIN 4
+// Blend of a mode change, shorter than the one of a scene
+#define MODE_TRANSITION 400
+
+/**
+ * Runs the frames of the RGB LEDs for the given time.
+ */
+static void run(LedStripRGB &rgb, uint16_t time)
+{
+  for(uint16_t elapsed = 0; elapsed < time; elapsed += 10)
+  {
+    delay(10);
+    rgb.loop();
+  }
+}
+
+/**
+ * Writes a scene in the first slot as an older or corrupt EEPROM would.
+ */
+static void writeScene(uint8_t mode)
+{
+  uint8_t *eeprom = hostEeprom();
+  // Header: only the first slot is stored and it is the last saved
+  eeprom[0] = 0x01;
+  eeprom[1] = 0x00;
+  eeprom[2] = 0;
+  const uint8_t scene[] = { (uint8_t)(mode | SCENE_RGB_ON), 0x00, 0x00, 0xFF, 64, 0 };
+  memcpy(eeprom + 3, scene, sizeof(scene));
+}
+
+void setUp(void)
+{
+  hostReset();
+  memset(hostEeprom(), 0xFF, HOST_EEPROM_SIZE);
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * The blend of a recall lasts SCENE_FADE_DURATION even when the mode of the
+ * scene is not the current one.
+ */
+void test_recall_fades_over_the_scene_duration(void)
+{
+  HostBoard &board = hostBoard();
+  LedStripRGB rgb({ 0, 1, BLUE_PIN });
+  LedStrip white(WHITE_PIN);
+  SceneStore scenes(rgb, white);
+  scenes.setup();
+  rgb.setTransitionTime(MODE_TRANSITION);
+  rgb.setColor(COLOR_BLUE);
+  rgb.turnOn();
+  scenes.save(0);
+  rgb.setColor(COLOR_RED);
+  rgb.setMode(LedStripRgbMode::STROBE);
+  run(rgb, 1000);
+  rgb.setMode(LedStripRgbMode::NORMAL);
+  run(rgb, 1000);
+  rgb.setMode(LedStripRgbMode::FADE);
+  run(rgb, 1000);
+
+  TEST_ASSERT_TRUE(scenes.recall(0));
+  run(rgb, MODE_TRANSITION + 50);
+  TEST_ASSERT_LESS_THAN(255, board.duty[BLUE_PIN]);
+  run(rgb, SCENE_FADE_DURATION - MODE_TRANSITION);
+  TEST_ASSERT_EQUAL(255, board.duty[BLUE_PIN]);
+  TEST_ASSERT_EQUAL(LedStripRgbMode::NORMAL, rgb.getMode());
+}
+
+/**
+ * A mode past the last one is shown as NORMAL, like the snapshot of a reset.
+ */
+void test_unknown_mode_is_recalled_as_normal(void)
+{
+  LedStripRGB rgb({ 0, 1, BLUE_PIN });
+  LedStrip white(WHITE_PIN);
+  SceneStore scenes(rgb, white);
+  writeScene(LedStripRgbMode::TWINKLE + 1);
+  scenes.setup();
+  rgb.setMode(LedStripRgbMode::FADE);
+  TEST_ASSERT_TRUE(scenes.recall(0));
+  TEST_ASSERT_EQUAL(LedStripRgbMode::NORMAL, rgb.getMode());
+  TEST_ASSERT_EQUAL_HEX32(COLOR_BLUE, rgb.getColor());
+  writeScene(SCENE_MODE_MASK);
+  rgb.setMode(LedStripRgbMode::FADE);
+  TEST_ASSERT_TRUE(scenes.recall(0));
+  TEST_ASSERT_EQUAL(LedStripRgbMode::NORMAL, rgb.getMode());
+}
+
+/**
+ * Music needs the audio analyzer, without it the scene is shown as NORMAL.
+ */
+void test_music_needs_an_analyzer(void)
+{
+  LedStripRGB rgb({ 0, 1, BLUE_PIN });
+  LedStrip white(WHITE_PIN);
+  SceneStore scenes(rgb, white);
+  writeScene(LedStripRgbMode::MUSIC);
+  scenes.setup();
+  TEST_ASSERT_TRUE(scenes.recall(0));
+  TEST_ASSERT_EQUAL(LedStripRgbMode::NORMAL, rgb.getMode());
+  writeScene(LedStripRgbMode::TWINKLE);
+  TEST_ASSERT_TRUE(scenes.recall(0));
+  TEST_ASSERT_EQUAL(LedStripRgbMode::TWINKLE, rgb.getMode());
+}
+
+/**
+ * A scene saved in the color temperature mode keeps the color and the mode
+ * of the RGB LEDs, not the tint of the mix.
+ */
+void test_save_during_the_mix_keeps_the_rgb_leds(void)
+{
+  LedStripRGB rgb({ 0, 1, BLUE_PIN });
+  LedStrip white(WHITE_PIN);
+  CctWhite cct(rgb, white);
+  SceneStore scenes(rgb, white);
+  scenes.setCctWhite(&cct);
+  scenes.setup();
+  rgb.setColor(COLOR_DARKPURPLE);
+  rgb.setMode(LedStripRgbMode::FADE);
+  rgb.turnOn();
+  white.turnOn();
+  cct.enable();
+  TEST_ASSERT_NOT_EQUAL(COLOR_DARKPURPLE, rgb.getColor());
+  scenes.save(0);
+  cct.disable();
+  rgb.setColor(COLOR_RED);
+  rgb.setMode(LedStripRgbMode::STROBE);
+  TEST_ASSERT_TRUE(scenes.recall(0));
+  TEST_ASSERT_EQUAL_HEX32(COLOR_DARKPURPLE, rgb.getColor());
+  TEST_ASSERT_EQUAL(LedStripRgbMode::FADE, rgb.getMode());
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_recall_fades_over_the_scene_duration);
+  RUN_TEST(test_unknown_mode_is_recalled_as_normal);
+  RUN_TEST(test_music_needs_an_analyzer);
+  RUN_TEST(test_save_during_the_mix_keeps_the_rgb_leds);
+  return UNITY_END();
+}
@@ -0,0 +1,232 @@
+/*
+ * test_schedule.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * SoftRTC and LightSchedule with accelerated time: the watchdog ticks are
+ * simulated with a period that is not one second, the system clock of the
+ * host board advances without waiting.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "SoftRTC.h"
+#include "LightSchedule.h"
+
+const ScheduleEntry table[] PROGMEM = {
+  { 1 * 60, 30, { 0x00, 0x00, 0x00 }, LedStripRgbMode::NORMAL },
+  { 6 * 60, 0, { 0x00, 0x00, 0x00 }, LedStripRgbMode::NORMAL },
+  { 18 * 60, 0, { 0x00, 0x00, 0x00 }, LedStripRgbMode::NORMAL },
+  { 19 * 60, 255, { 0x40, 0x18, 0x00 }, LedStripRgbMode::NORMAL },
+  { 22 * 60, 160, { 0x30, 0x10, 0x00 }, LedStripRgbMode::FLASH }
+};
+
+/**
+ * Runs the clock for the given time of the system clock, with a watchdog
+ * tick every period milliseconds and update() on every tick, as the main
+ * loop does while awake.
+ * @return Number of changes of minute
+ */
+static uint32_t run(SoftRTC &rtc, uint32_t duration, uint16_t period)
+{
+  uint32_t changes = 0;
+  for(uint32_t time = 0; time + period <= duration; time += period)
+  {
+    hostAdvance((uint32_t)period * 1000);
+    rtc.tick();
+    if(rtc.update())
+    {
+      changes++;
+    }
+  }
+  return changes;
+}
+
+void setUp(void)
+{
+  hostReset();
+}
+
+void tearDown(void)
+{
+}
+
+void test_time_is_set_in_minutes(void)
+{
+  SoftRTC rtc;
+  TEST_ASSERT_FALSE(rtc.isSet());
+  rtc.setTime(19 * 60 + 30);
+  TEST_ASSERT_TRUE(rtc.isSet());
+  TEST_ASSERT_EQUAL(19 * 60 + 30, rtc.getMinutes());
+  TEST_ASSERT_EQUAL((19 * 60 + 30) * 60UL, rtc.getSeconds());
+  rtc.setTime(MINUTES_PER_DAY + 5);
+  TEST_ASSERT_EQUAL(5, rtc.getMinutes());
+}
+
+void test_minute_changes_once_per_minute(void)
+{
+  SoftRTC rtc;
+  rtc.setTime(0);
+  TEST_ASSERT_EQUAL(60, run(rtc, 3600000UL, 1000));
+  TEST_ASSERT_EQUAL(60, rtc.getMinutes());
+}
+
+void test_clock_wraps_at_midnight(void)
+{
+  SoftRTC rtc;
+  rtc.setTime(MINUTES_PER_DAY - 1);
+  run(rtc, 120000UL, 1000);
+  TEST_ASSERT_EQUAL(1, rtc.getMinutes());
+}
+
+/**
+ * The watchdog oscillator is 10% off (fast and slow), once calibrated the
+ * clock is within a minute after a whole day.
+ */
+void test_calibration_follows_the_watchdog(void)
+{
+  const uint16_t periods[] = { 900, 1100, 1250 };
+  for(uint8_t i = 0; i < 3; i++)
+  {
+    SoftRTC rtc;
+    rtc.setTime(0);
+    run(rtc, SECONDS_PER_DAY * 1000UL, periods[i]);
+    TEST_ASSERT_INT_WITHIN(16, (uint32_t)periods[i] << 4, rtc.getTickPeriod());
+    uint32_t seconds = rtc.getSeconds();
+    int32_t error = seconds > SECONDS_PER_DAY / 2 ? seconds - SECONDS_PER_DAY : seconds;
+    TEST_ASSERT_INT_WITHIN(60, 0, error);
+  }
+}
+
+/**
+ * Several ticks counted while the CPU was busy are not used for the
+ * calibration, but they still count as time.
+ */
+void test_missed_updates_count_the_ticks(void)
+{
+  SoftRTC rtc;
+  rtc.setTime(0);
+  run(rtc, 10000UL, 1000);
+  for(uint8_t i = 0; i < 5; i++)
+  {
+    hostAdvance(3000000UL);
+    rtc.tick();
+  }
+  rtc.update();
+  TEST_ASSERT_EQUAL(15, rtc.getSeconds());
+  TEST_ASSERT_EQUAL(RTC_TICK_PERIOD, rtc.getTickPeriod());
+}
+
+void test_idle_waits_for_the_time(void)
+{
+  SoftRTC rtc;
+  uint32_t start = millis();
+  rtc.idle(BOARD_SCAN_DELAY);
+  TEST_ASSERT_EQUAL(BOARD_SCAN_DELAY, millis() - start);
+}
+
+void test_schedule_is_off_while_disabled(void)
+{
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(4);
+  LightSchedule schedule(rgb, white, table, array_length(table));
+  schedule.apply(20 * 60);
+  TEST_ASSERT_EQUAL(LedStripState::OFF, white.getState());
+  TEST_ASSERT_EQUAL(LedStripState::OFF, rgb.getState());
+}
+
+/**
+ * The points of the table are exact, between them the white and the color
+ * are interpolated and the mode is the one of the earlier point.
+ */
+void test_schedule_interpolates_the_points(void)
+{
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(4);
+  LightSchedule schedule(rgb, white, table, array_length(table));
+  schedule.enable();
+
+  schedule.apply(19 * 60);
+  TEST_ASSERT_EQUAL(255, white.getIntensity());
+  TEST_ASSERT_EQUAL_HEX32(0x401800, rgb.getColor());
+
+  schedule.apply(20 * 60 + 30);
+  TEST_ASSERT_INT_WITHIN(2, 207, white.getIntensity());
+  TEST_ASSERT_EQUAL(LedStripRgbMode::NORMAL, rgb.getMode());
+  TEST_ASSERT_INT_WITHIN(1, 0x38, rgb.getColor() >> 16);
+  TEST_ASSERT_INT_WITHIN(1, 0x14, (rgb.getColor() >> 8) & 0xFF);
+
+  schedule.apply(22 * 60 + 10);
+  TEST_ASSERT_EQUAL(LedStripRgbMode::FLASH, rgb.getMode());
+}
+
+/**
+ * The last point runs until the first one of the next day.
+ */
+void test_schedule_wraps_around_midnight(void)
+{
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(4);
+  LightSchedule schedule(rgb, white, table, array_length(table));
+  schedule.enable();
+  schedule.apply(0);
+  // 22:00 to 01:00, 2 of 3 hours from 160 to 30
+  TEST_ASSERT_INT_WITHIN(2, 73, white.getIntensity());
+  TEST_ASSERT_EQUAL(LedStripState::ON, white.getState());
+  schedule.apply(12 * 60);
+  TEST_ASSERT_EQUAL(LedStripState::OFF, white.getState());
+  TEST_ASSERT_EQUAL(LedStripState::OFF, rgb.getState());
+}
+
+/**
+ * A whole day of frames as in the main loop: the schedule is evaluated once
+ * per minute and the white never jumps by more than the slope of the table.
+ */
+void test_schedule_over_a_day(void)
+{
+  LedStripRGB rgb({ 0, 1, 3 });
+  LedStrip white(4);
+  LightSchedule schedule(rgb, white, table, array_length(table));
+  SoftRTC rtc;
+  rtc.setTime(18 * 60);
+  schedule.enable();
+  schedule.apply(rtc.getMinutes());
+  uint16_t applied = 0;
+  uint8_t last = white.getState() == LedStripState::ON ? white.getIntensity() : 0;
+  for(uint32_t second = 0; second < SECONDS_PER_DAY; second++)
+  {
+    hostAdvance(1000000UL);
+    rtc.tick();
+    if(rtc.update())
+    {
+      schedule.apply(rtc.getMinutes());
+      applied++;
+      uint8_t level = white.getState() == LedStripState::ON ? white.getIntensity() : 0;
+      int16_t change = (int16_t)level - last;
+      TEST_ASSERT_LESS_OR_EQUAL(5, change < 0 ? -change : change);
+      last = level;
+    }
+  }
+  TEST_ASSERT_EQUAL(MINUTES_PER_DAY, applied);
+  TEST_ASSERT_EQUAL(18 * 60, rtc.getMinutes());
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_time_is_set_in_minutes);
+  RUN_TEST(test_minute_changes_once_per_minute);
+  RUN_TEST(test_clock_wraps_at_midnight);
+  RUN_TEST(test_calibration_follows_the_watchdog);
+  RUN_TEST(test_missed_updates_count_the_ticks);
+  RUN_TEST(test_idle_waits_for_the_time);
+  RUN_TEST(test_schedule_is_off_while_disabled);
+  RUN_TEST(test_schedule_interpolates_the_points);
+  RUN_TEST(test_schedule_wraps_around_midnight);
+  RUN_TEST(test_schedule_over_a_day);
+  return UNITY_END();
+}
@@ -0,0 +1,212 @@
+/*
+ * test_speed_curve.cpp
+ * Created by Jose Rivera, Feb 2018.
+ *
+ * This work is licensed under a Creative Commons Attribution 4.0 International License.
+ * http://creativecommons.org/licenses/by/4.0/
+ */
+
+/*
+ * Period of the Flash and Fade steps at each position of the potentiometer,
+ * from the speed curve and from the colors shown by LedStripRGB, which maps
+ * the potentiometer onto the curve from one step per frame to 10 s.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <unity.h>
+#include "SpeedCurve.h"
+#include "LedStripRGB.h"
+
+// Period of a step in milliseconds at a speed (a decade every 256 points)
+static double expectedPeriod(uint16_t speed)
+{
+  return pow(10.0, speed / 256.0);
+}
+
+static double curvePeriod(uint16_t speed)
+{
+  return (double)SPEED_CURVE_PHASE_ONE / speedToStepRate(speed);
+}
+
+// Period of a step of the effects of LedStripRGB at a pot position
+static double effectPeriod(uint16_t position)
+{
+  return expectedPeriod(speedFrom(position, EFFECT_MIN_SPEED));
+}
+
+static uint32_t shownColor(void)
+{
+  HostBoard &board = hostBoard();
+  return ((uint32_t)board.duty[0] << 16) | ((uint32_t)board.duty[1] << 8) | board.duty[2];
+}
+
+static uint8_t flashIndex(uint32_t color)
+{
+  for(uint8_t i = 0; i < FLASH_COLORS_SEQUENCE_LENGTH; i++)
+  {
+    if(pgm_read_dword(&FLASH_COLORS_SEQUENCE[i]) == color)
+    {
+      return i;
+    }
+  }
+  return 0xFF;
+}
+
+void setUp(void)
+{
+  hostReset();
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * At the points of the table the period is exact, between them the rate is
+ * interpolated linearly, which is within 2% of the logarithmic curve (the
+ * rates of the table are rounded to integers).
+ */
+void test_period_at_each_pot_position(void)
+{
+  for(uint16_t position = 0; position <= SPEED_CURVE_MAX; position += 8)
+  {
+    double expected = expectedPeriod(position);
+    double tolerance = (position & 0x1F) == 0 ? 0.01 : 0.02;
+    char message[48];
+    snprintf(message, sizeof(message), "pot position %u", position);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(expected * tolerance + 0.01, expected,
+      curvePeriod(position), message);
+  }
+}
+
+void test_period_covers_four_decades(void)
+{
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 1.0, curvePeriod(0));
+  TEST_ASSERT_FLOAT_WITHIN(1.0, 100.0, curvePeriod(512));
+  TEST_ASSERT_FLOAT_WITHIN(100.0, 10000.0, curvePeriod(SPEED_CURVE_MAX));
+  TEST_ASSERT_EQUAL_UINT32(speedToStepRate(SPEED_CURVE_MAX), speedToStepRate(0xFFFF));
+}
+
+void test_rate_is_monotonic(void)
+{
+  uint32_t last = speedToStepRate(0);
+  for(uint16_t speed = 1; speed <= SPEED_CURVE_MAX; speed++)
+  {
+    uint32_t rate = speedToStepRate(speed);
+    TEST_ASSERT_LESS_OR_EQUAL(last, rate);
+    last = rate;
+  }
+}
+
+/**
+ * Counts the changes of color of the Flash mode over 20 s of frames.
+ */
+static double measureFlashPeriod(uint16_t speed)
+{
+  LedStripRGB strip({ 0, 1, 2 });
+  strip.setup();
+  strip.setMode(LedStripRgbMode::FLASH);
+  strip.setSpeed(speed);
+  strip.turnOn();
+  strip.loop();
+  uint32_t color = shownColor();
+  uint32_t changes = 0;
+  uint32_t duration = 20000;
+  for(uint32_t time = 0; time < duration; time += BOARD_FRAME_DELAY)
+  {
+    delay(BOARD_FRAME_DELAY);
+    strip.loop();
+    if(shownColor() != color)
+    {
+      color = shownColor();
+      changes++;
+    }
+  }
+  return changes > 0 ? (double)duration / changes : duration;
+}
+
+/**
+ * The speeds of the frames are the first speed of the curve with a period of
+ * at least 10 and 20 ms.
+ */
+void test_frame_speeds(void)
+{
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 10.0, curvePeriod(SPEED_CURVE_10MS));
+  TEST_ASSERT_TRUE(curvePeriod(SPEED_CURVE_10MS - 1) < 10.0);
+  TEST_ASSERT_TRUE(curvePeriod(SPEED_CURVE_20MS) >= 20.0);
+  TEST_ASSERT_TRUE(curvePeriod(SPEED_CURVE_20MS - 1) < 20.0);
+  TEST_ASSERT_EQUAL(EFFECT_MIN_SPEED, speedFrom(0, EFFECT_MIN_SPEED));
+  TEST_ASSERT_EQUAL(SPEED_CURVE_MAX, speedFrom(SPEED_CURVE_MAX, EFFECT_MIN_SPEED));
+}
+
+void test_flash_period_follows_the_curve(void)
+{
+  const uint16_t speeds[] = { 128, 256, 384, 512 };
+  for(uint8_t i = 0; i < array_length(speeds); i++)
+  {
+    double expected = effectPeriod(speeds[i]);
+    char message[32];
+    snprintf(message, sizeof(message), "speed %u", speeds[i]);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(expected * 0.03 + 1.0, expected,
+      measureFlashPeriod(speeds[i]), message);
+  }
+}
+
+/**
+ * The fastest position of the potentiometer is one step per frame and every
+ * position above it is slower, no part of the range is lost to the limit.
+ */
+void test_whole_pot_range_changes_the_flash(void)
+{
+  TEST_ASSERT_FLOAT_WITHIN(1.0, BOARD_FRAME_DELAY, measureFlashPeriod(0));
+  double last = measureFlashPeriod(0);
+  for(uint16_t speed = 32; speed <= 320; speed += 32)
+  {
+    double period = measureFlashPeriod(speed);
+    TEST_ASSERT_TRUE(period > last);
+    TEST_ASSERT_FLOAT_WITHIN(effectPeriod(speed) * 0.03 + 1.0, effectPeriod(speed), period);
+    last = period;
+  }
+}
+
+/**
+ * Below one frame per step the sequence is limited to the next color on
+ * every frame, it does not skip colors.
+ */
+void test_fast_flash_shows_every_color(void)
+{
+  for(uint16_t speed = 0; speed < 320; speed += 32)
+  {
+    LedStripRGB strip({ 0, 1, 2 });
+    strip.setup();
+    strip.setMode(LedStripRgbMode::FLASH);
+    strip.setSpeed(speed);
+    strip.turnOn();
+    strip.loop();
+    uint8_t index = flashIndex(shownColor());
+    for(uint8_t frame = 0; frame < 60; frame++)
+    {
+      delay(BOARD_FRAME_DELAY);
+      strip.loop();
+      uint8_t next = flashIndex(shownColor());
+      TEST_ASSERT_NOT_EQUAL(0xFF, next);
+      uint8_t step = (next + FLASH_COLORS_SEQUENCE_LENGTH - index) % FLASH_COLORS_SEQUENCE_LENGTH;
+      TEST_ASSERT_LESS_OR_EQUAL(1, step);
+      index = next;
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_period_at_each_pot_position);
+  RUN_TEST(test_period_covers_four_decades);
+  RUN_TEST(test_rate_is_monotonic);
+  RUN_TEST(test_frame_speeds);
+  RUN_TEST(test_flash_period_follows_the_curve);
+  RUN_TEST(test_whole_pot_range_changes_the_flash);
+  RUN_TEST(test_fast_flash_shows_every_color);
+  return UNITY_END();
+}